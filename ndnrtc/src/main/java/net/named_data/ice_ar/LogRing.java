@@ -0,0 +1,183 @@
+/* -*- Mode:jde; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+package net.named_data.ice_ar;
+
+import java.io.File;
+import java.io.IOException;
+import java.io.RandomAccessFile;
+import java.nio.ByteOrder;
+import java.nio.MappedByteBuffer;
+import java.nio.channels.FileChannel;
+import java.nio.charset.StandardCharsets;
+
+/**
+ * Read-only view of the memory-mapped native log ring.
+ * <p/>
+ * The layout is defined in jni/log-ring.hpp.  Offsets used here are the monotonic offsets of
+ * the native side; a record is valid only while its offset is not behind the ring's tail.
+ */
+class LogRing {
+  static final String FILE_NAME = "ice-ar-log.ring";
+
+  static final byte TYPE_PADDING = 0;
+  static final byte TYPE_TEXT = 1;
+  static final byte TYPE_BINARY = 2;
+
+  /**
+   * Open ring file written by the native code
+   *
+   * @return ring or null if the file doesn't exist (yet) or has unexpected layout
+   */
+  static LogRing
+  open(File file)
+  {
+    if (!file.exists()) {
+      return null;
+    }
+
+    try (RandomAccessFile raf = new RandomAccessFile(file, "r");
+         FileChannel channel = raf.getChannel()) {
+      MappedByteBuffer buffer = channel.map(FileChannel.MapMode.READ_ONLY, 0, channel.size());
+      buffer.order(ByteOrder.nativeOrder());
+      if (buffer.capacity() < HEADER_SIZE ||
+          buffer.getInt(0) != MAGIC || buffer.getInt(4) != VERSION ||
+          HEADER_SIZE + (buffer.getInt(8) & 0xffffffffL) > buffer.capacity()) {
+        return null;
+      }
+      return new LogRing(buffer);
+    }
+    catch (IOException e) {
+      return null;
+    }
+  }
+
+  private LogRing(MappedByteBuffer buffer)
+  {
+    m_buffer = buffer;
+    m_dataSize = buffer.getInt(8) & 0xffffffffL;
+  }
+
+  /** Monotonic offset where the next record will be written */
+  long
+  getHead()
+  {
+    return m_buffer.getLong(16);
+  }
+
+  /** Monotonic offset of the oldest complete record */
+  long
+  getTail()
+  {
+    return m_buffer.getLong(24);
+  }
+
+  /**
+   * @return size of record at offset (to get to the next one), or 0 if record is not valid
+   */
+  int
+  getRecordSize(long offset)
+  {
+    int size = m_buffer.getInt(position(offset));
+    if (size <= 0 || size % 8 != 0 || size > m_dataSize ||
+        (size < RECORD_HEADER_SIZE && getType(offset) != TYPE_PADDING)) {
+      return 0;
+    }
+    return isValid(offset) ? size : 0;
+  }
+
+  byte
+  getType(long offset)
+  {
+    return m_buffer.get(position(offset) + 4);
+  }
+
+  String
+  getSeverity(long offset)
+  {
+    int severity = m_buffer.get(position(offset) + 5) & 0xff;
+    return severity < SEVERITIES.length ? SEVERITIES[severity] : "ALL";
+  }
+
+  long
+  getTimestamp(long offset)
+  {
+    return m_buffer.getLong(position(offset) + 16);
+  }
+
+  String
+  getModule(long offset)
+  {
+    int pos = position(offset);
+    int moduleSize = m_buffer.getShort(pos + 6) & 0xffff;
+    return getString(pos + RECORD_HEADER_SIZE, moduleSize);
+  }
+
+  /**
+   * Get message text; binary records are formatted by the native code
+   */
+  String
+  getMessage(long offset)
+  {
+    byte[] payload = getPayload(offset);
+    if (getType(offset) == TYPE_BINARY) {
+      return NdnRtcWrapper.formatLogRecord(payload);
+    }
+    return new String(payload, StandardCharsets.UTF_8);
+  }
+
+  byte[]
+  getPayload(long offset)
+  {
+    int pos = position(offset);
+    int moduleSize = m_buffer.getShort(pos + 6) & 0xffff;
+    int payloadSize = m_buffer.getInt(pos + 8);
+    return getBytes(pos + RECORD_HEADER_SIZE + moduleSize, payloadSize);
+  }
+
+  /**
+   * Check that record at offset has not been overwritten; to be called after decoding
+   */
+  boolean
+  isValid(long offset)
+  {
+    return offset >= getTail() && offset < getHead();
+  }
+
+  private int
+  position(long offset)
+  {
+    return HEADER_SIZE + (int)(offset % m_dataSize);
+  }
+
+  private String
+  getString(int position, int size)
+  {
+    return new String(getBytes(position, size), StandardCharsets.UTF_8);
+  }
+
+  private byte[]
+  getBytes(int position, int size)
+  {
+    if (size < 0 || position + size > m_buffer.capacity()) {
+      return new byte[0];
+    }
+    byte[] bytes = new byte[size];
+    for (int i = 0; i < size; ++i) {
+      bytes[i] = m_buffer.get(position + i);
+    }
+    return bytes;
+  }
+
+  //////////////////////////////////////////////////////////////////////////////
+
+  private static final int MAGIC = 0x524c4349; // 'ICLR'
+  private static final int VERSION = 1;
+  private static final int HEADER_SIZE = 64;
+  private static final int RECORD_HEADER_SIZE = 24;
+
+  /** Indexed by ndn::util::LogLevel + 1 */
+  private static final String[] SEVERITIES = {"FATAL", "NONE", "ERROR", "WARN", "INFO", "DEBUG", "TRACE"};
+
+  private final MappedByteBuffer m_buffer;
+  private final long m_dataSize;
+}
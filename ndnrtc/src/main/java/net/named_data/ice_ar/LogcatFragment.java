@@ -5,7 +5,8 @@ package net.named_data.ice_ar;
 import android.annotation.SuppressLint;
 import android.graphics.Color;
 import android.os.Bundle;
-import android.util.Log;
+import android.os.Handler;
+import android.os.Looper;
 import android.view.LayoutInflater;
 import android.view.View;
 import android.view.ViewGroup;
@@ -14,14 +15,18 @@ import android.widget.BaseAdapter;
 import android.widget.ListView;
 import android.widget.TextView;
 
-import java.util.ArrayList;
+import java.io.File;
 import java.util.HashMap;
 
-import androidx.annotation.Keep;
 import androidx.annotation.Nullable;
 import androidx.fragment.app.Fragment;
 
-public class LogcatFragment extends Fragment implements NdnRtcWrapper.Logger {
+/**
+ * Log viewer that polls the memory-mapped native log ring (see LogRing).
+ * <p/>
+ * Only offsets of shown records are kept; a record is decoded when its row becomes visible.
+ */
+public class LogcatFragment extends Fragment {
   private static final String TAG = LogcatFragment.class.getName();
 
   @Override
@@ -56,18 +61,18 @@ public class LogcatFragment extends Fragment implements NdnRtcWrapper.Logger {
     m_logListView.setOnItemClickListener((AdapterView<?> parent, View view, int position, long id) -> {
       TextView msg = (TextView)view.findViewById(R.id.log_line);
 
-      LogListAdapter.Item item = (LogListAdapter.Item) m_logListAdapter.getItem(position);
-
       int lineCount = msg.getLineCount();
-      if (item.lines == lineCount) {
-        item.lines = 1;
+      int lines = m_logListAdapter.getLines(position);
+      if (lines == lineCount) {
+        lines = 1;
       }
       else {
-        item.lines = lineCount;
+        lines = lineCount;
       }
+      m_logListAdapter.setLines(position, lines);
 
-      msg.setMaxLines(item.lines);
-      msg.setMinLines(item.lines);
+      msg.setMaxLines(lines);
+      msg.setMinLines(lines);
     });
 
     return v;
@@ -77,61 +82,99 @@ public class LogcatFragment extends Fragment implements NdnRtcWrapper.Logger {
   public void onResume()
   {
     super.onResume();
-    NdnRtcWrapper.attach(this);
+    m_handler.post(m_poll);
   }
 
   @Override
   public void onPause()
   {
     super.onPause();
-    NdnRtcWrapper.detach(this);
-  }
-
-  @Keep @Override
-  public void
-  addMessageFromNative(String module, String severity, String message)
-  {
-    getActivity().runOnUiThread(() -> {
-      if (severity.equals("TRACE")) {
-        // suppress all trace stuff
-        return;
-      }
-      if (module.equals("ndn.Face") && severity.equals("DEBUG")) {
-        if (message.contains("/localhost/nfd")) {
-          // ignore all face exchanges to/from local NFD
-          return;
-        }
-      }
-      appendLogText(module, severity, message);
-    });
+    m_handler.removeCallbacks(m_poll);
   }
 
   //////////////////////////////////////////////////////////////////////////////
 
   /**
-   * Clear log adapter and update UI.
+   * Clear log adapter and update UI.  Records already in the ring are not shown again.
    */
   public void clearLog()
   {
     m_logListAdapter.clearMessages();
+    if (m_ring != null) {
+      m_cursor = m_ring.getHead();
+    }
   }
 
   /**
-   * Convenience method to append a message to the log output
-   * and scroll to the bottom of the log.
-   *
-   * @param message String message to be posted to the text view.
+   * Index records appended since the last poll and scroll to the bottom of the log
    */
-  private void appendLogText(String module, String severity, String message) {
-    m_logListAdapter.addMessage(module, severity, message);
-    m_logListView.setSelection(m_logListAdapter.getCount() - 1);
+  private void pollLog()
+  {
+    if (m_ring == null && getContext() != null) {
+      // the ring is created by the native code on start
+      m_ring = LogRing.open(new File(getContext().getFilesDir(), LogRing.FILE_NAME));
+    }
+
+    if (m_ring != null) {
+      long head = m_ring.getHead();
+      long tail = m_ring.getTail();
+      if (m_cursor < tail) {
+        // either first poll or fell behind the writer
+        m_cursor = tail;
+      }
+
+      boolean hasNew = false;
+      while (m_cursor < head) {
+        int size = m_ring.getRecordSize(m_cursor);
+        if (size == 0) {
+          // overwritten while reading, resync on the next poll
+          break;
+        }
+        if (isShown(m_cursor)) {
+          m_logListAdapter.addOffset(m_cursor);
+          hasNew = true;
+        }
+        m_cursor += size;
+      }
+
+      boolean hasDropped = m_logListAdapter.dropBefore(m_ring.getTail());
+      if (hasNew || hasDropped) {
+        m_logListAdapter.notifyDataSetChanged();
+      }
+      if (hasNew) {
+        m_logListView.setSelection(m_logListAdapter.getCount() - 1);
+      }
+    }
+
+    m_handler.postDelayed(m_poll, s_pollIntervalMs);
+  }
+
+  private boolean isShown(long offset)
+  {
+    byte type = m_ring.getType(offset);
+    if (type != LogRing.TYPE_TEXT && type != LogRing.TYPE_BINARY) {
+      return false;
+    }
+
+    String severity = m_ring.getSeverity(offset);
+    if (severity.equals("TRACE")) {
+      // suppress all trace stuff
+      return false;
+    }
+    if (severity.equals("DEBUG") && m_ring.getModule(offset).equals("ndn.Face")) {
+      if (m_ring.getMessage(offset).contains("/localhost/nfd")) {
+        // ignore all face exchanges to/from local NFD
+        return false;
+      }
+    }
+    return true;
   }
 
   /**
    * Custom LogListAdapter to limit the number of log lines that
    * is being stored and displayed.
    */
-  private static class LogListAdapter extends BaseAdapter {
+  private class LogListAdapter extends BaseAdapter {
 
     /**
      * Create a ListView compatible adapter with an
@@ -143,26 +186,41 @@ public class LogcatFragment extends Fragment implements NdnRtcWrapper.Logger {
      */
     LogListAdapter(LayoutInflater layoutInflater, int maxLines,
                    HashMap<String, ColorsItem> colorMap, ColorsItem defaultColor) {
-      m_data = new ArrayList<>();
+      m_offsets = new long[maxLines];
+      m_lines = new int[maxLines];
       m_layoutInflater = layoutInflater;
-      m_maxLines = maxLines;
       m_colorMap = colorMap;
       m_defaultColor = defaultColor;
     }
 
     /**
-     * Add a message to be displayed in the log's list view.
-     *
-     * @param message Message to be added to the underlying data store
-     *                and displayed on thi UI.
+     * Add ring record to be displayed in the log's list view, evicting the oldest one if full
      */
-    void addMessage(String module, String level, String message) {
-      if (m_data.size() == m_maxLines) {
-        m_data.remove(0);
+    void addOffset(long offset) {
+      if (m_count == m_offsets.length) {
+        m_first = (m_first + 1) % m_offsets.length;
+        --m_count;
       }
 
-      m_data.add(new Item(module, level, message));
-      notifyDataSetChanged();
+      int index = (m_first + m_count) % m_offsets.length;
+      m_offsets[index] = offset;
+      m_lines[index] = 1;
+      ++m_count;
+    }
+
+    /**
+     * Forget records that have been overwritten in the ring
+     *
+     * @return whether any record has been dropped
+     */
+    boolean dropBefore(long tail) {
+      boolean hasDropped = false;
+      while (m_count > 0 && m_offsets[m_first] < tail) {
+        m_first = (m_first + 1) % m_offsets.length;
+        --m_count;
+        hasDropped = true;
+      }
+      return hasDropped;
     }
 
     /**
@@ -170,23 +228,32 @@ public class LogcatFragment extends Fragment implements NdnRtcWrapper.Logger {
      * data store and update the UI.
      */
     void clearMessages() {
-      m_data.clear();
+      m_first = 0;
+      m_count = 0;
       this.notifyDataSetChanged();
     }
 
+    int getLines(int position) {
+      return m_lines[index(position)];
+    }
+
+    void setLines(int position, int lines) {
+      m_lines[index(position)] = lines;
+    }
+
     @Override
     public int getCount() {
-      return m_data.size();
+      return m_count;
     }
 
     @Override
     public Object getItem(int position) {
-      return m_data.get(position);
+      return m_offsets[index(position)];
     }
 
     @Override
     public long getItemId(int position) {
-      return position;
+      return m_offsets[index(position)];
     }
 
     @SuppressLint("InflateParams")
@@ -206,12 +273,21 @@ public class LogcatFragment extends Fragment implements NdnRtcWrapper.Logger {
         holder = (LogEntryViewHolder) convertView.getTag();
       }
 
-      Item item = m_data.get(position);
-      holder.logLineTextView.setText(item.message);
-      holder.logLineTextView.setMaxLines(item.lines);
-      holder.logLineTextView.setMinLines(item.lines);
-      holder.logLevel.setText(item.level.substring(0, 1));
-      ColorsItem color = m_colorMap.get(item.level);
+      long offset = m_offsets[index(position)];
+      String level = m_ring.getSeverity(offset);
+      String message = m_ring.getMessage(offset);
+      if (!m_ring.isValid(offset)) {
+        // overwritten while decoding; the row goes away on the next poll
+        level = "NONE";
+        message = "";
+      }
+
+      int lines = getLines(position);
+      holder.logLineTextView.setText(message);
+      holder.logLineTextView.setMaxLines(lines);
+      holder.logLineTextView.setMinLines(lines);
+      holder.logLevel.setText(level.substring(0, 1));
+      ColorsItem color = m_colorMap.get(level);
       if (color == null) {
         color = m_defaultColor;
       }
@@ -220,30 +296,22 @@ public class LogcatFragment extends Fragment implements NdnRtcWrapper.Logger {
       return convertView;
     }
 
-    class Item {
-      Item(final String module, final String level, final String message)
-      {
-        this.module = module;
-        this.level = level;
-        this.message = message;
-        this.lines = 1;
-      }
-
-      String module;
-      String level;
-      String message;
-      int lines;
+    private int index(int position) {
+      return (m_first + position) % m_offsets.length;
     }
 
-    /** Underlying message data store for log messages*/
-    private final ArrayList<Item> m_data;
+    /** Ring offsets of shown records (circular buffer) */
+    private final long[] m_offsets;
+
+    /** Number of lines each record is expanded to */
+    private final int[] m_lines;
+
+    private int m_first = 0;
+    private int m_count = 0;
 
     /** Layout inflater for inflating views */
     private final LayoutInflater m_layoutInflater;
 
-    /** Maximum number of log lines to display */
-    private final int m_maxLines;
-
     private HashMap<String, ColorsItem> m_colorMap;
     ColorsItem m_defaultColor;
   }
@@ -261,8 +329,17 @@ public class LogcatFragment extends Fragment implements NdnRtcWrapper.Logger {
   /** Maximum number of log lines to be displayed by the backing adapter of the ListView */
   private static final int s_logMaxLines = 380;
 
-  /** Process in which logcat is running in */
-  private Process m_logProcess;
+  /** How often to check the ring for new records */
+  private static final long s_pollIntervalMs = 250;
+
+  private final Handler m_handler = new Handler(Looper.getMainLooper());
+  private final Runnable m_poll = this::pollLog;
+
+  /** Native log ring, null until created by the native code */
+  private LogRing m_ring;
+
+  /** Offset of the next record to be indexed */
+  private long m_cursor = 0;
 
   /** ListView for displaying log output in */
   private ListView m_logListView;
@@ -4,6 +4,7 @@ import java.util.Map;
 
 public class NdnRtcWrapper {
   static {
+    System.loadLibrary("icear-core");
     System.loadLibrary("ice-ar-wrapper");
   }
 
@@ -32,12 +33,53 @@ public class NdnRtcWrapper {
   public native static void
   start(Map<String, String> params, StartStopNotify notify);
 
+  /**
+   * Stop the service; returns immediately.  notify.onStopped() of the running service is called
+   * once it is gone, within about a second.  A start() made before that runs when it is gone.
+   */
   public native static void
   stop();
 
+  /**
+   * Restart the service with new parameters
+   * <p/>
+   * If the service is running with the same forwarder transport (homePath and faceCapture /
+   * faceReplay parameters), only the bootstrap is run again, keeping the connection, keys, routes
+   * and CA state; notify is not used then.  Otherwise, the service is stopped and started anew.
+   */
+  public native static void
+  restart(Map<String, String> params, StartStopNotify notify);
+
   public native static void
   attach(Logger logger);
 
   public native static void
   detach(Logger logger);
+
+  /**
+   * Format binary log record (LogRing.TYPE_BINARY) payload as text
+   */
+  public native static String
+  formatLogRecord(byte[] payload);
+
+  /**
+   * Statistics of the running service as a JSON object, e.g., I/O loop lag histogram, the
+   * stack of the last loop stall and arena allocations of the last bootstrap session; "{}" if the
+   * service is not running
+   */
+  public native static String
+  getStats();
+
+  /**
+   * Snapshot of the native metrics (counters, gauges and latency histograms); binary layout is
+   * described in metrics.hpp.  Available whether the service is running or not
+   */
+  public native static byte[]
+  getMetrics();
+
+  /**
+   * Names of the metrics, in the order they appear in getMetrics() snapshot
+   */
+  public native static String[]
+  getMetricNames();
 }
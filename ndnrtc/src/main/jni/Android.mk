@@ -1,14 +1,35 @@
 LOCAL_PATH := $(call my-dir)
 LOCAL_PATH_SAVED := $(LOCAL_PATH)
 
+# Platform-independent bootstrap client with C API (icear-core.h)
 include $(CLEAR_VARS)
-LOCAL_MODULE := ice-ar-wrapper
-LOCAL_SRC_FILES := ice-ar-wrapper.cpp mobile-terminal.cpp location-client-tool.cpp
+LOCAL_MODULE := icear-core
+LOCAL_SRC_FILES := icear-core.cpp mobile-terminal.cpp location-client-tool.cpp rtt-estimator.cpp session-arena.cpp location-challenge-tlv.cpp ca-verifier-cache.cpp ca-location-cache.cpp route-lease-manager.cpp log-ring.cpp binary-log.cpp face-capture.cpp timer-wheel.cpp latency-window.cpp loop-monitor.cpp metrics.cpp network-change-filter.cpp
 LOCAL_SHARED_LIBRARIES := ndn_cxx_shared ndncert_guest_shared boost_system_shared boost_thread_shared boost_log_shared boost_stacktrace_basic_shared boost_chrono_shared
-LOCAL_LDLIBS := -llog -latomic
+LOCAL_LDLIBS := -latomic
 LOCAL_CFLAGS := -DBOOST_LOG_DYN_LINK -DBOOST_STACKTRACE_DYN_LINK
+LOCAL_EXPORT_C_INCLUDES := $(LOCAL_PATH)
 include $(BUILD_SHARED_LIBRARY)
 
+include $(CLEAR_VARS)
+LOCAL_MODULE := ice-ar-wrapper
+LOCAL_SRC_FILES := ice-ar-wrapper.cpp
+LOCAL_SHARED_LIBRARIES := icear-core ndn_cxx_shared boost_log_shared
+LOCAL_LDLIBS := -llog
+LOCAL_CFLAGS := -DBOOST_LOG_DYN_LINK
+include $(BUILD_SHARED_LIBRARY)
+
+# Microbenchmarks of the native hot paths; run on a device with
+#   adb push libs/<abi>/ice-ar-benchmarks libs/<abi>/*.so /data/local/tmp/
+#   adb shell 'cd /data/local/tmp && LD_LIBRARY_PATH=. ./ice-ar-benchmarks' > results.jsonl
+include $(CLEAR_VARS)
+LOCAL_MODULE := ice-ar-benchmarks
+LOCAL_SRC_FILES := benchmarks/benchmark.cpp benchmarks/bench-jni.cpp benchmarks/bench-fib.cpp benchmarks/bench-ndncert.cpp
+LOCAL_SHARED_LIBRARIES := ice-ar-wrapper icear-core ndn_cxx_shared ndncert_guest_shared boost_system_shared boost_log_shared
+LOCAL_LDLIBS := -llog
+LOCAL_CFLAGS := -DBOOST_LOG_DYN_LINK
+include $(BUILD_EXECUTABLE)
+
 # Explicitly define versions of precompiled modules
 $(call import-module,../packages/ndn_cxx/0.6.6-1)
 $(call import-module,../packages/ndncert_guest/0.1.1-1)
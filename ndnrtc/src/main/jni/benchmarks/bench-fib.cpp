@@ -0,0 +1,90 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+/**
+ * FIB dataset handling of MobileTerminal::waitUntilFibEntryHasNextHop: decoding the dataset (as
+ * nfd::Controller does for FibDataset) and scanning it for the registered prefix.
+ */
+
+#include "benchmark.hpp"
+#include "../mobile-terminal.hpp"
+
+#include <ndn-cxx/mgmt/nfd/fib-entry.hpp>
+
+namespace icear {
+namespace bench {
+
+using ndn::Block;
+using ndn::Name;
+using ndn::nfd::FibEntry;
+using ndn::nfd::NextHopRecord;
+
+static const uint64_t TARGET_FACE_ID = 262;
+
+/**
+ * @brief FIB of @p nEntries entries, with the prefix being looked for at the very end
+ */
+static Block
+makeFibDataset(size_t nEntries, Name& target)
+{
+  Block payload(ndn::tlv::Content);
+  for (size_t i = 0; i < nEntries; ++i) {
+    FibEntry entry;
+    entry.setPrefix(Name("/ndn/edu/site").appendNumber(i));
+    entry.addNextHopRecord(NextHopRecord().setFaceId(256 + i % 16).setCost(10));
+    entry.addNextHopRecord(NextHopRecord().setFaceId(1).setCost(100));
+    if (i + 1 == nEntries) {
+      target = entry.getPrefix();
+      entry.addNextHopRecord(NextHopRecord().setFaceId(TARGET_FACE_ID).setCost(1));
+    }
+    payload.push_back(entry.wireEncode());
+  }
+  payload.encode();
+  return payload;
+}
+
+static std::vector<FibEntry>
+parseFibDataset(const Block& payload)
+{
+  payload.parse();
+  std::vector<FibEntry> fib;
+  fib.reserve(payload.elements_size());
+  for (const auto& element : payload.elements()) {
+    fib.emplace_back(element);
+  }
+  return fib;
+}
+
+static void
+registerFibBenchmarks()
+{
+  for (size_t nEntries : {10, 100, 1000, 10000, 100000}) {
+    add("fib_has_next_hop", std::to_string(nEntries), [nEntries] (State& state) {
+        Name target;
+        auto fib = parseFibDataset(makeFibDataset(nEntries, target));
+
+        state.startTimer();
+        for (size_t i = 0; i < state.getIterations(); ++i) {
+          doNotOptimize(ndn::ndncert::hasNextHop(fib, target, TARGET_FACE_ID));
+        }
+        state.stopTimer();
+      });
+
+    add("fib_dataset_parse_and_scan", std::to_string(nEntries), [nEntries] (State& state) {
+        Name target;
+        Block wire = makeFibDataset(nEntries, target);
+
+        state.startTimer();
+        for (size_t i = 0; i < state.getIterations(); ++i) {
+          // fresh copy, as each fetch brings a new dataset
+          Block payload(wire.wire(), wire.size());
+          doNotOptimize(ndn::ndncert::hasNextHop(parseFibDataset(payload), target, TARGET_FACE_ID));
+        }
+        state.stopTimer();
+      });
+  }
+}
+
+ICEAR_BENCHMARKS(registerFibBenchmarks);
+
+} // namespace bench
+} // namespace icear
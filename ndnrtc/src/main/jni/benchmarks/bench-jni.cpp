@@ -0,0 +1,364 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+/**
+ * JNI-facing paths: start parameters conversion and log sink, driven by a fake JNIEnv.
+ *
+ * The fake environment hands out pointers to C++ objects instead of copying strings, and Java
+ * log subscribers just count what they get, so the numbers reflect the wrapper's own cost, not
+ * that of the VM.
+ */
+
+#include "benchmark.hpp"
+#include "../binary-log.hpp"
+#include "../ice-ar-wrapper.hpp"
+#include "../log-ring.hpp"
+
+#include <ndn-cxx/util/logger.hpp>
+#include <ndn-cxx/util/logging.hpp>
+
+#include <boost/log/core.hpp>
+
+#include <jni.h>
+
+#include <cstdarg>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+// defined in ice-ar-wrapper.cpp
+std::map<std::string, std::string>
+getParams(JNIEnv* env, jobject jParams);
+
+void
+init(JNIEnv* env);
+
+namespace icear {
+namespace bench {
+
+NDN_LOG_INIT(icear.Benchmark);
+
+namespace fake {
+
+struct String
+{
+  std::string value;
+};
+
+struct Entry
+{
+  String key;
+  String value;
+};
+
+struct Map
+{
+  std::vector<Entry> entries;
+};
+
+struct Iterator
+{
+  Map* map;
+  size_t next;
+};
+
+/**
+ * @brief Stands for the Java log subscriber (addMessageFromNative)
+ */
+struct Logger
+{
+  size_t nMessages = 0;
+  size_t nBytes = 0;
+};
+
+enum Method {
+  ENTRY_SET,
+  ITERATOR,
+  HAS_NEXT,
+  NEXT,
+  GET_KEY,
+  GET_VALUE,
+  ADD_MESSAGE,
+  N_METHODS
+};
+
+static const char* const METHOD_NAMES[] = {"entrySet", "iterator", "hasNext", "next", "getKey", "getValue",
+                                           "addMessageFromNative"};
+static int g_methodIds[N_METHODS];
+static int g_class;
+static Iterator g_iterator; // the wrapper iterates over a single map at a time
+// the log sink creates three strings per record and drops them before the next one
+static String g_strings[3];
+static size_t g_nextString = 0;
+
+template<typename T, typename U>
+static T*
+cast(U* object)
+{
+  return reinterpret_cast<T*>(object);
+}
+
+static Method
+getMethod(jmethodID id)
+{
+  return static_cast<Method>(reinterpret_cast<int*>(id) - g_methodIds);
+}
+
+static jclass
+getObjectClass(JNIEnv*, jobject)
+{
+  return cast<_jclass>(&g_class);
+}
+
+static jclass
+findClass(JNIEnv*, const char*)
+{
+  return cast<_jclass>(&g_class);
+}
+
+static jmethodID
+getMethodId(JNIEnv*, jclass, const char* name, const char*)
+{
+  for (int i = 0; i < N_METHODS; ++i) {
+    if (std::strcmp(name, METHOD_NAMES[i]) == 0) {
+      return cast<_jmethodID>(&g_methodIds[i]);
+    }
+  }
+  return nullptr;
+}
+
+static jobject
+callObjectMethodV(JNIEnv*, jobject object, jmethodID id, va_list)
+{
+  switch (getMethod(id)) {
+  case ENTRY_SET:
+    return object; // map doubles as its entry set
+  case ITERATOR:
+    g_iterator = {cast<Map>(object), 0};
+    return cast<_jobject>(&g_iterator);
+  case NEXT: {
+    auto iterator = cast<Iterator>(object);
+    return cast<_jobject>(&iterator->map->entries[iterator->next++]);
+  }
+  case GET_KEY:
+    return cast<_jobject>(&cast<Entry>(object)->key);
+  case GET_VALUE:
+    return cast<_jobject>(&cast<Entry>(object)->value);
+  default:
+    return nullptr;
+  }
+}
+
+static jboolean
+callBooleanMethodV(JNIEnv*, jobject object, jmethodID, va_list)
+{
+  auto iterator = cast<Iterator>(object);
+  return iterator->next < iterator->map->entries.size() ? JNI_TRUE : JNI_FALSE;
+}
+
+static const char*
+getStringUtfChars(JNIEnv*, jstring string, jboolean* isCopy)
+{
+  if (isCopy != nullptr) {
+    *isCopy = JNI_FALSE;
+  }
+  return cast<String>(string)->value.c_str();
+}
+
+static void
+releaseStringUtfChars(JNIEnv*, jstring, const char*)
+{
+}
+
+static jstring
+newStringUtf(JNIEnv*, const char* bytes)
+{
+  String& string = g_strings[g_nextString++ % 3];
+  string.value.assign(bytes);
+  return cast<_jstring>(&string);
+}
+
+static void
+callVoidMethodV(JNIEnv*, jobject object, jmethodID, va_list args)
+{
+  auto logger = cast<Logger>(object);
+  for (int i = 0; i < 3; ++i) { // module, severity, message
+    logger->nBytes += cast<String>(va_arg(args, jstring))->value.size();
+  }
+  ++logger->nMessages;
+}
+
+static jobject
+newRef(JNIEnv*, jobject object)
+{
+  return object;
+}
+
+static void
+deleteRef(JNIEnv*, jobject)
+{
+}
+
+static jboolean
+isSameObject(JNIEnv*, jobject first, jobject second)
+{
+  return first == second ? JNI_TRUE : JNI_FALSE;
+}
+
+static JNIEnv*
+getEnv();
+
+static jint
+getEnvFromVm(JavaVM*, void** env, jint)
+{
+  *env = getEnv();
+  return JNI_OK;
+}
+
+static jint
+getJavaVm(JNIEnv*, JavaVM** vm)
+{
+  static JNIInvokeInterface functions;
+  static JavaVM fakeVm;
+  static bool isInitialized = false;
+  if (!isInitialized) {
+    std::memset(&functions, 0, sizeof(functions));
+    functions.GetEnv = &getEnvFromVm;
+    fakeVm.functions = &functions;
+    isInitialized = true;
+  }
+  *vm = &fakeVm;
+  return JNI_OK;
+}
+
+static JNIEnv*
+getEnv()
+{
+  static JNINativeInterface functions;
+  static JNIEnv env;
+  static bool isInitialized = false;
+  if (!isInitialized) {
+    std::memset(&functions, 0, sizeof(functions));
+    functions.GetObjectClass = &getObjectClass;
+    functions.FindClass = &findClass;
+    functions.GetMethodID = &getMethodId;
+    functions.CallObjectMethodV = &callObjectMethodV;
+    functions.CallBooleanMethodV = &callBooleanMethodV;
+    functions.GetStringUTFChars = &getStringUtfChars;
+    functions.ReleaseStringUTFChars = &releaseStringUtfChars;
+    functions.NewStringUTF = &newStringUtf;
+    functions.CallVoidMethodV = &callVoidMethodV;
+    functions.NewGlobalRef = &newRef;
+    functions.DeleteGlobalRef = &deleteRef;
+    functions.DeleteLocalRef = &deleteRef;
+    functions.IsSameObject = &isSameObject;
+    functions.GetJavaVM = &getJavaVm;
+    env.functions = &functions;
+    isInitialized = true;
+  }
+  return &env;
+}
+
+} // namespace fake
+
+static std::string
+getTempPath(const std::string& name)
+{
+  const char* tmp = std::getenv("TMPDIR");
+  return std::string(tmp != nullptr ? tmp : "/data/local/tmp") + "/" + name;
+}
+
+static void
+registerJniBenchmarks()
+{
+  for (size_t nParams : {4, 64}) {
+    add("jni_get_params", std::to_string(nParams), [nParams] (State& state) {
+        fake::Map params;
+        params.entries.push_back({{"homePath"}, {"/data/user/0/net.named_data.ice_ar.sec_demo1/files"}});
+        for (size_t i = 1; i < nParams; ++i) {
+          params.entries.push_back({{"param" + std::to_string(i)}, {"value" + std::to_string(i)}});
+        }
+
+        JNIEnv* env = fake::getEnv();
+        state.startTimer();
+        for (size_t i = 0; i < state.getIterations(); ++i) {
+          auto result = getParams(env, fake::cast<_jobject>(&params));
+          doNotOptimize(result);
+        }
+        state.stopTimer();
+      });
+  }
+
+  // record formatted, passed through the core's sink and delivered to each attached Java logger
+  for (size_t nSubscribers : {1, 4}) {
+    add("sink_consume", std::to_string(nSubscribers), [nSubscribers] (State& state) {
+        static bool isSinkInstalled = false;
+        if (!isSinkInstalled) {
+          // leave only the core's sink, without ndn-cxx's console sink
+          boost::log::core::get()->remove_all_sinks();
+          init(fake::getEnv());
+          ndn::util::Logging::setLevel("icear.Benchmark=INFO");
+          isSinkInstalled = true;
+        }
+
+        JNIEnv* env = fake::getEnv();
+        std::vector<fake::Logger> loggers(nSubscribers);
+        for (auto& logger : loggers) {
+          Java_net_named_1data_ice_1ar_NdnRtcWrapper_attach(env, nullptr, fake::cast<_jobject>(&logger));
+        }
+
+        state.startTimer();
+        for (size_t i = 0; i < state.getIterations(); ++i) {
+          NDN_LOG_INFO("Check if FIB entry /localhop/ndn-autoconf/CA exists with nexthop " << i);
+        }
+        state.stopTimer();
+
+        for (auto& logger : loggers) {
+          Java_net_named_1data_ice_1ar_NdnRtcWrapper_detach(env, nullptr, fake::cast<_jobject>(&logger));
+          if (logger.nMessages != state.getIterations()) {
+            throw std::runtime_error("Subscriber got " + std::to_string(logger.nMessages) + " of " +
+                                     std::to_string(state.getIterations()) + " records");
+          }
+        }
+      });
+  }
+
+  add("log_ring_append", "text", [] (State& state) {
+      std::string path = getTempPath("ice-ar-bench.ring");
+      ::unlink(path.c_str());
+      LogRing ring(path);
+      std::string module = "ndncert.MobileTerminal";
+      std::string message = "Check if FIB entry /localhop/ndn-autoconf/CA exists with nexthop 262";
+
+      state.startTimer();
+      for (size_t i = 0; i < state.getIterations(); ++i) {
+        ring.append(static_cast<int>(ndn::util::LogLevel::INFO), module, message);
+      }
+      state.stopTimer();
+    });
+
+  add("log_ring_append", "binary", [] (State& state) {
+      std::string path = getTempPath("ice-ar-bench.ring");
+      ::unlink(path.c_str());
+      LogRing ring(path);
+      blog::setRing(&ring);
+      ndn::util::Logging::setLevel("icear.Benchmark=INFO");
+      ndn::Name prefix("/localhop/ndn-autoconf/CA");
+
+      state.startTimer();
+      for (size_t i = 0; i < state.getIterations(); ++i) {
+        ICEAR_BLOG_INFO(CHECK_FIB_ENTRY, prefix, uint64_t(262), i);
+      }
+      state.stopTimer();
+
+      blog::setRing(nullptr);
+    });
+}
+
+ICEAR_BENCHMARKS(registerJniBenchmarks);
+
+} // namespace bench
+} // namespace icear
@@ -0,0 +1,201 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+/**
+ * NDNCERT client paths: LocationClientTool construction, requester key generation, challenge code
+ * decryption and signing of the localhop validation Interest, for each key type ndn-cxx supports.
+ */
+
+#include "benchmark.hpp"
+#include "../location-client-tool.hpp"
+
+#include <ndncert/challenge-module/location-challenge.hpp>
+
+#include <ndn-cxx/encoding/buffer-stream.hpp>
+#include <ndn-cxx/security/key-chain.hpp>
+#include <ndn-cxx/security/signing-helpers.hpp>
+#include <ndn-cxx/security/transform.hpp>
+#include <ndn-cxx/util/dummy-client-face.hpp>
+
+#include <iostream>
+#include <sstream>
+
+namespace icear {
+namespace bench {
+
+using namespace ndn;
+using namespace ndn::ndncert;
+
+/**
+ * @brief In-memory KeyChain with a CA identity and RSA and EC requester keys, shared by all runs
+ */
+class Keys
+{
+public:
+  static Keys&
+  get()
+  {
+    static Keys keys;
+    return keys;
+  }
+
+  const security::Key&
+  getKey(const std::string& type) const
+  {
+    return type == "rsa" ? rsaKey : ecKey;
+  }
+
+  /**
+   * @brief Parameters of key type @p type, as ClientModule would use for the requester key
+   */
+  static std::unique_ptr<KeyParams>
+  makeKeyParams(const std::string& type)
+  {
+    if (type == "rsa") {
+      return std::make_unique<RsaKeyParams>();
+    }
+    return std::make_unique<EcKeyParams>();
+  }
+
+private:
+  Keys()
+    : keyChain("pib-memory:", "tpm-memory:")
+  {
+    caCert = keyChain.createIdentity("/bench/ca").getDefaultKey().getDefaultCertificate();
+    rsaKey = keyChain.createIdentity("/bench/rsa", RsaKeyParams()).getDefaultKey();
+    ecKey = keyChain.createIdentity("/bench/ec", EcKeyParams()).getDefaultKey();
+  }
+
+public:
+  KeyChain keyChain;
+  security::v2::Certificate caCert;
+  security::Key rsaKey;
+  security::Key ecKey;
+};
+
+/**
+ * @brief Encrypt @p code to @p key as a CA does for the LOCATION challenge
+ */
+static ConstBufferPtr
+encryptCode(const std::string& code, const security::Key& key)
+{
+  security::transform::PublicKey publicKey;
+  publicKey.loadPkcs8(key.getPublicKey().data(), key.getPublicKey().size());
+  return publicKey.encrypt(reinterpret_cast<const uint8_t*>(code.data()), code.size());
+}
+
+/**
+ * @brief Same Interest as LocationClientTool::makeLocalhopValidateInterest (TLV encoding), unsigned
+ */
+static Interest
+makeLocalhopValidateInterest()
+{
+  LocalhopValidateRequest request;
+  request.requestId = "2a9bd5fe7ab9e1c2";
+  request.challengeType = "LOCATION";
+  request.status = "need-localhop";
+  request.code = "274316";
+
+  Interest interest(Name(LocationChallenge::LOCALHOP_VALIDATION_PREFIX).append(request.wireEncode()));
+  interest.setCanBePrefix(false);
+  return interest;
+}
+
+static void
+registerNdncertBenchmarks()
+{
+  add("location_client_tool_construct", "", [] (State& state) {
+      Keys& keys = Keys::get();
+      util::DummyClientFace face(keys.keyChain);
+      CaContext ca;
+      CaVerifierCache verifiers;
+
+      // the constructor dumps the generated config to stderr
+      std::ostringstream discard;
+      auto cerrBuf = std::cerr.rdbuf(discard.rdbuf());
+
+      state.startTimer();
+      for (size_t i = 0; i < state.getIterations(); ++i) {
+        LocationClientTool tool(face, keys.keyChain, "/bench/ca", keys.caCert, ca, verifiers);
+        doNotOptimize(tool);
+        discard.str("");
+      }
+      state.stopTimer();
+
+      std::cerr.rdbuf(cerrBuf);
+    });
+
+  // key pair generation for a new NDNCERT request
+  for (std::string keyType : {"rsa", "ec"}) {
+    add("create_key", keyType, [keyType] (State& state) {
+        Keys& keys = Keys::get();
+        auto identity = keys.keyChain.createIdentity("/bench/keygen");
+        auto params = Keys::makeKeyParams(keyType);
+
+        for (size_t i = 0; i < state.getIterations(); ++i) {
+          state.startTimer();
+          auto key = keys.keyChain.createKey(identity, *params);
+          state.stopTimer();
+          keys.keyChain.deleteKey(identity, key);
+        }
+      });
+  }
+
+  // the TPM decrypts with RSA keys only; EC requester keys can't be used with the LOCATION challenge
+  for (std::string keyType : {"rsa"}) {
+    add("decrypt_code", keyType, [keyType] (State& state) {
+        Keys& keys = Keys::get();
+        const security::Key& key = keys.getKey(keyType);
+        auto encrypted = encryptCode("274316", key);
+
+        SessionArena arena;
+
+        state.startTimer();
+        for (size_t i = 0; i < state.getIterations(); ++i) {
+          doNotOptimize(decryptCode(encrypted->data(), encrypted->size(), keys.keyChain, key.getName(), arena));
+          arena.release();
+        }
+        state.stopTimer();
+      });
+
+    add("base64_decode_and_decrypt_code", keyType, [keyType] (State& state) {
+        Keys& keys = Keys::get();
+        const security::Key& key = keys.getKey(keyType);
+        auto encrypted = encryptCode("274316", key);
+
+        namespace t = security::transform;
+        std::ostringstream os;
+        t::bufferSource(*encrypted) >> t::base64Encode() >> t::streamSink(os);
+        std::string encoded = os.str();
+
+        SessionArena arena;
+
+        state.startTimer();
+        for (size_t i = 0; i < state.getIterations(); ++i) {
+          doNotOptimize(base64DecodeAndDecryptCode(encoded, keys.keyChain, key.getName(), arena));
+          arena.release();
+        }
+        state.stopTimer();
+      });
+  }
+
+  for (std::string keyType : {"rsa", "ec"}) {
+    add("sign_localhop_validate_interest", keyType, [keyType] (State& state) {
+        Keys& keys = Keys::get();
+        const security::Key& key = keys.getKey(keyType);
+        Interest unsignedInterest = makeLocalhopValidateInterest();
+
+        state.startTimer();
+        for (size_t i = 0; i < state.getIterations(); ++i) {
+          Interest interest(unsignedInterest);
+          keys.keyChain.sign(interest, signingByKey(key.getName()));
+          doNotOptimize(interest.wireEncode());
+        }
+        state.stopTimer();
+      });
+  }
+}
+
+ICEAR_BENCHMARKS(registerNdncertBenchmarks);
+
+} // namespace bench
+} // namespace icear
@@ -0,0 +1,149 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+/**
+ * Microbenchmarks of the native hot paths.
+ *
+ * Usage: ice-ar-benchmarks [--min-time-ms=<ms>] [--samples=<n>] [<name-filter>...]
+ *
+ * Each result is printed to stdout as one JSON object per line:
+ *
+ *     {"name": "...", "arg": "...", "iterations": N, "samples": S,
+ *      "ns_per_op": <median>, "min_ns_per_op": <min>, "max_ns_per_op": <max>}
+ */
+
+#include "benchmark.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+namespace icear {
+namespace bench {
+
+struct Benchmark
+{
+  std::string name;
+  std::string arg;
+  Function function;
+};
+
+static std::vector<Benchmark>&
+getRegistry()
+{
+  static std::vector<Benchmark> registry;
+  return registry;
+}
+
+void
+add(const std::string& name, const std::string& arg, const Function& function)
+{
+  getRegistry().push_back({name, arg, function});
+}
+
+static std::chrono::nanoseconds
+runOnce(const Benchmark& benchmark, size_t nIterations)
+{
+  State state(nIterations);
+  benchmark.function(state);
+  return state.getElapsed();
+}
+
+/**
+ * @brief Find iteration count that takes at least @p minTime
+ */
+static size_t
+calibrate(const Benchmark& benchmark, std::chrono::nanoseconds minTime)
+{
+  size_t nIterations = 1;
+  while (true) {
+    auto elapsed = runOnce(benchmark, nIterations);
+    if (elapsed >= minTime || nIterations >= (size_t(1) << 30)) {
+      return nIterations;
+    }
+    // aim slightly above the target, growing at most 10x per round
+    double ratio = elapsed.count() > 0 ? 1.2 * minTime.count() / elapsed.count() : 10;
+    nIterations = std::max(nIterations + 1, static_cast<size_t>(nIterations * std::min(ratio, 10.0)));
+  }
+}
+
+static void
+printJsonString(std::ostream& os, const std::string& value)
+{
+  os << '"';
+  for (char c : value) {
+    if (c == '"' || c == '\\') {
+      os << '\\';
+    }
+    os << c;
+  }
+  os << '"';
+}
+
+static void
+run(const Benchmark& benchmark, std::chrono::nanoseconds minTime, size_t nSamples)
+{
+  size_t nIterations = calibrate(benchmark, minTime);
+
+  std::vector<double> nsPerOp;
+  for (size_t i = 0; i < nSamples; ++i) {
+    nsPerOp.push_back(static_cast<double>(runOnce(benchmark, nIterations).count()) / nIterations);
+  }
+  std::sort(nsPerOp.begin(), nsPerOp.end());
+
+  std::cout << "{\"name\": ";
+  printJsonString(std::cout, benchmark.name);
+  std::cout << ", \"arg\": ";
+  printJsonString(std::cout, benchmark.arg);
+  std::cout << ", \"iterations\": " << nIterations
+            << ", \"samples\": " << nSamples
+            << ", \"ns_per_op\": " << nsPerOp[nsPerOp.size() / 2]
+            << ", \"min_ns_per_op\": " << nsPerOp.front()
+            << ", \"max_ns_per_op\": " << nsPerOp.back()
+            << "}" << std::endl;
+}
+
+} // namespace bench
+} // namespace icear
+
+int
+main(int argc, char** argv)
+{
+  using namespace icear::bench;
+
+  std::chrono::nanoseconds minTime = std::chrono::milliseconds(200);
+  size_t nSamples = 5;
+  std::vector<std::string> filters;
+  for (int i = 1; i < argc; ++i) {
+    if (std::strncmp(argv[i], "--min-time-ms=", 14) == 0) {
+      minTime = std::chrono::milliseconds(std::atoi(argv[i] + 14));
+    }
+    else if (std::strncmp(argv[i], "--samples=", 10) == 0) {
+      nSamples = std::max(1, std::atoi(argv[i] + 10));
+    }
+    else {
+      filters.push_back(argv[i]);
+    }
+  }
+
+  for (const auto& benchmark : getRegistry()) {
+    bool isSelected = filters.empty() ||
+                      std::any_of(filters.begin(), filters.end(), [&benchmark] (const std::string& filter) {
+                          return benchmark.name.find(filter) != std::string::npos;
+                        });
+    if (!isSelected) {
+      continue;
+    }
+
+    std::cerr << "Running " << benchmark.name << "/" << benchmark.arg << std::endl;
+    try {
+      run(benchmark, minTime, nSamples);
+    }
+    catch (const std::exception& e) {
+      std::cerr << "ERROR: " << benchmark.name << "/" << benchmark.arg << ": " << e.what() << std::endl;
+      return 1;
+    }
+  }
+
+  return 0;
+}
@@ -0,0 +1,87 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#ifndef ICEAR_BENCHMARKS_BENCHMARK_HPP
+#define ICEAR_BENCHMARKS_BENCHMARK_HPP
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace icear {
+namespace bench {
+
+/**
+ * @brief Timing context passed to a benchmark function
+ *
+ * The function does its setup, then runs the measured operation getIterations() times between
+ * startTimer() and stopTimer().
+ */
+class State
+{
+public:
+  explicit
+  State(size_t nIterations)
+    : m_nIterations(nIterations)
+  {
+  }
+
+  size_t
+  getIterations() const
+  {
+    return m_nIterations;
+  }
+
+  void
+  startTimer()
+  {
+    m_start = std::chrono::steady_clock::now();
+  }
+
+  void
+  stopTimer()
+  {
+    m_elapsed += std::chrono::steady_clock::now() - m_start;
+  }
+
+  std::chrono::nanoseconds
+  getElapsed() const
+  {
+    return m_elapsed;
+  }
+
+private:
+  size_t m_nIterations;
+  std::chrono::steady_clock::time_point m_start;
+  std::chrono::nanoseconds m_elapsed{0};
+};
+
+using Function = std::function<void(State& state)>;
+
+/**
+ * @brief Register benchmark @p name; @p arg distinguishes variants (e.g., input size)
+ */
+void
+add(const std::string& name, const std::string& arg, const Function& function);
+
+/**
+ * @brief Keep the compiler from optimizing away computation of @p value
+ */
+template<typename T>
+inline void
+doNotOptimize(const T& value)
+{
+  asm volatile("" : : "r,m"(value) : "memory");
+}
+
+} // namespace bench
+} // namespace icear
+
+/**
+ * @brief Run @p registerFunction (which calls bench::add) before main()
+ */
+#define ICEAR_BENCHMARKS(registerFunction) \
+  static const bool registerFunction##Registered = (registerFunction(), true)
+
+#endif // ICEAR_BENCHMARKS_BENCHMARK_HPP
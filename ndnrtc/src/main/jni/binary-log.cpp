@@ -0,0 +1,227 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#include "binary-log.hpp"
+
+#include <atomic>
+#include <cstring>
+#include <sstream>
+
+namespace icear {
+namespace blog {
+
+static const char* const FORMATS[] = {
+#define ICEAR_BLOG_FORMAT_STRING(id, format) format,
+  ICEAR_BLOG_FORMATS(ICEAR_BLOG_FORMAT_STRING)
+#undef ICEAR_BLOG_FORMAT_STRING
+};
+
+static const size_t N_FORMATS = sizeof(FORMATS) / sizeof(FORMATS[0]);
+
+static std::atomic<LogRing*> g_ring{nullptr};
+static std::atomic<TextListener> g_textListener{nullptr};
+
+void
+Encoder::begin(Format format)
+{
+  m_buffer.clear();
+  uint16_t id = static_cast<uint16_t>(format);
+  m_buffer.resize(sizeof(id) + 1);
+  std::memcpy(m_buffer.data(), &id, sizeof(id));
+  m_buffer[sizeof(id)] = 0;
+}
+
+void
+Encoder::addFixed(ArgType type, uint64_t value)
+{
+  size_t offset = m_buffer.size();
+  m_buffer.resize(offset + 1 + sizeof(value));
+  m_buffer[offset] = type;
+  std::memcpy(m_buffer.data() + offset + 1, &value, sizeof(value));
+  ++m_buffer[2];
+}
+
+void
+Encoder::addBytes(ArgType type, const uint8_t* bytes, size_t size)
+{
+  uint32_t size32 = static_cast<uint32_t>(size);
+  size_t offset = m_buffer.size();
+  m_buffer.resize(offset + 1 + sizeof(size32) + size);
+  m_buffer[offset] = type;
+  std::memcpy(m_buffer.data() + offset + 1, &size32, sizeof(size32));
+  std::memcpy(m_buffer.data() + offset + 1 + sizeof(size32), bytes, size);
+  ++m_buffer[2];
+}
+
+void
+Encoder::add(const std::string& value)
+{
+  addBytes(STRING, reinterpret_cast<const uint8_t*>(value.data()), value.size());
+}
+
+void
+Encoder::add(const char* value)
+{
+  addBytes(STRING, reinterpret_cast<const uint8_t*>(value), std::strlen(value));
+}
+
+void
+Encoder::add(const ndn::Name& name)
+{
+  const ndn::Block& wire = name.wireEncode();
+  addBytes(NAME, wire.wire(), wire.size());
+}
+
+void
+Encoder::add(const ndn::security::v2::Certificate& cert)
+{
+  const ndn::Block& wire = cert.wireEncode();
+  addBytes(CERTIFICATE, wire.wire(), wire.size());
+}
+
+void
+Encoder::add(ndn::lp::NackReason reason)
+{
+  addFixed(NACK_REASON, static_cast<uint64_t>(reason));
+}
+
+void
+setRing(LogRing* ring)
+{
+  g_ring = ring;
+}
+
+void
+setTextListener(TextListener listener)
+{
+  g_textListener = listener;
+}
+
+bool
+write(const ndn::util::Logger& logger, ndn::util::LogLevel level, const Encoder& encoder)
+{
+  LogRing* ring = g_ring.load(std::memory_order_acquire);
+  if (ring == nullptr) {
+    return false;
+  }
+
+  ring->append(LogRing::BINARY, static_cast<int>(level), logger.getModuleName(),
+               encoder.data(), encoder.size());
+
+  TextListener listener = g_textListener.load(std::memory_order_acquire);
+  if (listener != nullptr) {
+    listener(logger.getModuleName(), level, format(encoder.data(), encoder.size()));
+  }
+  return true;
+}
+
+/**
+ * @brief Print one argument from @p payload at @p pos, advancing @p pos
+ * @return false if the argument is truncated or has unknown type
+ */
+static bool
+formatArg(std::ostream& os, const uint8_t* payload, size_t size, size_t& pos)
+{
+  if (pos + 1 > size) {
+    return false;
+  }
+  uint8_t type = payload[pos++];
+
+  switch (type) {
+  case Encoder::UNSIGNED:
+  case Encoder::SIGNED:
+  case Encoder::MILLISECONDS:
+  case Encoder::NACK_REASON: {
+    uint64_t value;
+    if (pos + sizeof(value) > size) {
+      return false;
+    }
+    std::memcpy(&value, payload + pos, sizeof(value));
+    pos += sizeof(value);
+
+    if (type == Encoder::UNSIGNED) {
+      os << value;
+    }
+    else if (type == Encoder::SIGNED) {
+      os << static_cast<int64_t>(value);
+    }
+    else if (type == Encoder::MILLISECONDS) {
+      os << ndn::time::milliseconds(static_cast<int64_t>(value));
+    }
+    else {
+      os << static_cast<ndn::lp::NackReason>(value);
+    }
+    return true;
+  }
+  case Encoder::STRING:
+  case Encoder::NAME:
+  case Encoder::CERTIFICATE: {
+    uint32_t length;
+    if (pos + sizeof(length) > size) {
+      return false;
+    }
+    std::memcpy(&length, payload + pos, sizeof(length));
+    pos += sizeof(length);
+    if (pos + length > size) {
+      return false;
+    }
+    const uint8_t* value = payload + pos;
+    pos += length;
+
+    if (type == Encoder::STRING) {
+      os.write(reinterpret_cast<const char*>(value), length);
+      return true;
+    }
+
+    try {
+      ndn::Block block(value, length);
+      if (type == Encoder::NAME) {
+        os << ndn::Name(block);
+      }
+      else {
+        os << ndn::security::v2::Certificate(block);
+      }
+    }
+    catch (const std::exception& e) {
+      os << "<undecodable: " << e.what() << ">";
+    }
+    return true;
+  }
+  default:
+    return false;
+  }
+}
+
+std::string
+format(const uint8_t* payload, size_t size)
+{
+  uint16_t id;
+  if (size < sizeof(id) + 1) {
+    return "<truncated binary log record>";
+  }
+  std::memcpy(&id, payload, sizeof(id));
+  uint8_t nArgs = payload[sizeof(id)];
+  if (id >= N_FORMATS) {
+    return "<unknown binary log format " + std::to_string(id) + ">";
+  }
+
+  std::ostringstream os;
+  size_t pos = sizeof(id) + 1;
+  uint8_t nFormatted = 0;
+  for (const char* p = FORMATS[id]; *p != '\0'; ++p) {
+    if (p[0] == '{' && p[1] == '}') {
+      if (nFormatted < nArgs && !formatArg(os, payload, size, pos)) {
+        os << "<malformed>";
+        break;
+      }
+      ++nFormatted;
+      ++p;
+    }
+    else {
+      os << *p;
+    }
+  }
+  return os.str();
+}
+
+} // namespace blog
+} // namespace icear
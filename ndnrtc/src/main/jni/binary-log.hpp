@@ -0,0 +1,243 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#ifndef ICEAR_BINARY_LOG_HPP
+#define ICEAR_BINARY_LOG_HPP
+
+#include "log-ring.hpp"
+
+#include <ndn-cxx/lp/nack-header.hpp>
+#include <ndn-cxx/name.hpp>
+#include <ndn-cxx/security/v2/certificate.hpp>
+#include <ndn-cxx/util/logger.hpp>
+#include <ndn-cxx/util/time.hpp>
+
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace icear {
+namespace blog {
+
+/**
+ * @brief Table of log formats; `{}` is replaced by the next argument
+ *
+ * Format IDs are stored in log files and decoded offline, so entries must only be appended.
+ */
+#define ICEAR_BLOG_FORMATS(X) \
+  X(AP_CHANGE,               "Detected AP change. Re-run NDNCERT") \
+  X(SESSION_START,           "Starting bootstrap session {}") \
+  X(SESSION_CANCEL,          "Cancelling bootstrap session {} in state {}") \
+  X(SESSION_ARENA_STATS,     "Session used {} arena allocations ({} bytes, {} overflow chunks)") \
+  X(REQUEST_CERT_FROM_CA,    "Requesting certificate from CA {}") \
+  X(CHECK_FIB_ENTRY,         "Check if FIB entry {} exists with nexthop {}, retries left: {}") \
+  X(FIB_CHECK_ERROR,         "ERROR `{}` when checking for FIB entry for {} prefix. Cannot proceed") \
+  X(REGISTER_ERROR,          "ERROR `{}` when registering {} prefix. Cannot proceed") \
+  X(DISCOVER_CA,             "Discover localhop CA via {} (lifetime {})") \
+  X(DISCOVERY_BAD_SIGNATURE, "Discovery data {} is not signed by the advertised CA certificate") \
+  X(MISSING_INCOMING_FACE,   "Incoming data missing IncomingFaceIdTag") \
+  X(DISCOVERED_CA,           "Discovered CA {}\nCA's certificate: {}") \
+  X(DISCOVERY_NACK,          "   Got NACK ({}). Retrying after 1 sec delay...") \
+  X(DISCOVERY_TIMEOUT,       "   Got timeout. Retrying with lifetime {}...") \
+  X(GENERIC_ERROR,           "ERROR: {}") \
+  X(RERUN_COMPLETE,          "Delayed re-run of NDNCERT (complete)") \
+  X(RERUN_CERT_ONLY,         "Delayed re-run on NDNCERT (cert only)") \
+  X(EXCEPTION,               "{}") \
+  X(LOCALHOP_JSON_FALLBACK,  "No answer to TLV {} request, falling back to JSON") \
+  X(CERT_ALREADY_ISSUED,     "DONE! Certificate has already been issued") \
+  X(GOT_CERT,                "Got CERT:{}\n{}") \
+  X(LOCALHOP_TIMEOUT,        "{} timed out, retrying with lifetime {}") \
+  X(LOCALHOP_SENT,           "{} interest sent") \
+  X(LOCALHOP_RESPONSE,       "Got {} response with status {}") \
+  X(LOCALHOP_TLV_RESPONSE,   "Got TLV {} response with status {}") \
+  X(TIMER_STATS,             "Timers: {} wakeups for {} timers ({} wakeups/hour)") \
+  X(HEDGE_START,             "Step {} of request to {} exceeded {}, hedging with another CA") \
+  X(HEDGE_ABANDONED,         "Hedged request abandoned: {}") \
+  X(ISSUANCE_WINNER,         "Certificate issued first by {} ({} request)") \
+  X(LOOP_STALL,              "I/O loop stalled for {} in:\n{}") \
+  X(RESTART,                 "Restarting bootstrap on request") \
+  X(NETWORK_CHANGE,          "Network change on {}, now: {}") \
+  X(DISCOVER_CACHED_CA,      "Ask cached CA {} via {} on face {} (lifetime {})") \
+  X(CA_CACHE_MISS,           "Cached CA {} not usable ({}), discovering via multicast") \
+  X(LOCALHOP_JSON_REPLY,     "CA answered TLV {} request in JSON, asking again in JSON") \
+  X(DISCOVERY_BAD_CERT,      "Discovery data {} carries unusable CA certificate: {}")
+
+enum class Format : uint16_t {
+#define ICEAR_BLOG_FORMAT_ID(id, format) id,
+  ICEAR_BLOG_FORMATS(ICEAR_BLOG_FORMAT_ID)
+#undef ICEAR_BLOG_FORMAT_ID
+};
+
+/**
+ * @brief Encoder of binary log payload
+ *
+ *     Payload = uint16 format ID, uint8 argument count, Argument*
+ *     Argument = uint8 ArgType, value
+ *
+ * UNSIGNED, SIGNED and MILLISECONDS values are 8 octets; NACK_REASON is 8 octets (the numeric
+ * reason); STRING, NAME and CERTIFICATE values are uint32 length followed by raw bytes or TLV
+ * wire encoding.  All integers are in host byte order.
+ */
+class Encoder
+{
+public:
+  enum ArgType : uint8_t {
+    UNSIGNED = 0,
+    SIGNED = 1,
+    STRING = 2,
+    NAME = 3,
+    CERTIFICATE = 4,
+    MILLISECONDS = 5,
+    NACK_REASON = 6
+  };
+
+  void
+  begin(Format format);
+
+  template<typename T>
+  typename std::enable_if<std::is_integral<T>::value>::type
+  add(T value)
+  {
+    if (std::is_signed<T>::value) {
+      addFixed(SIGNED, static_cast<uint64_t>(static_cast<int64_t>(value)));
+    }
+    else {
+      addFixed(UNSIGNED, static_cast<uint64_t>(value));
+    }
+  }
+
+  template<typename Rep, typename Period>
+  void
+  add(const ndn::time::duration<Rep, Period>& duration)
+  {
+    auto ms = ndn::time::duration_cast<ndn::time::milliseconds>(duration).count();
+    addFixed(MILLISECONDS, static_cast<uint64_t>(static_cast<int64_t>(ms)));
+  }
+
+  void
+  add(const std::string& value);
+
+  void
+  add(const char* value);
+
+  /**
+   * @note Name and certificate are copied as TLV; their wire encoding is normally cached already
+   */
+  void
+  add(const ndn::Name& name);
+
+  void
+  add(const ndn::security::v2::Certificate& cert);
+
+  void
+  add(ndn::lp::NackReason reason);
+
+  void
+  addAll()
+  {
+  }
+
+  template<typename T, typename... Rest>
+  void
+  addAll(const T& first, const Rest&... rest)
+  {
+    add(first);
+    addAll(rest...);
+  }
+
+  const uint8_t*
+  data() const
+  {
+    return m_buffer.data();
+  }
+
+  size_t
+  size() const
+  {
+    return m_buffer.size();
+  }
+
+private:
+  void
+  addFixed(ArgType type, uint64_t value);
+
+  void
+  addBytes(ArgType type, const uint8_t* bytes, size_t size);
+
+private:
+  std::vector<uint8_t> m_buffer;
+};
+
+/**
+ * @brief Per-thread encoder, reset with the given format
+ */
+template<typename... Args>
+Encoder&
+encode(Format format, const Args&... args)
+{
+  static thread_local Encoder encoder;
+  encoder.begin(format);
+  encoder.addAll(args...);
+  return encoder;
+}
+
+/**
+ * @brief Enable binary records in @p ring, or disable binary mode if nullptr
+ *
+ * In binary mode the records bypass Boost.Log (and so its sinks) and go straight into the ring;
+ * otherwise they are formatted in place and logged as text.
+ */
+void
+setRing(LogRing* ring);
+
+using TextListener = void (*)(const std::string& module, ndn::util::LogLevel level,
+                              const std::string& message);
+
+/**
+ * @brief Also pass records written in binary mode, formatted, to @p listener; nullptr to stop
+ *
+ * Meant to be set only while someone listens: it costs the formatting binary mode defers.
+ */
+void
+setTextListener(TextListener listener);
+
+/**
+ * @brief Write encoded record to the ring
+ * @return false if binary mode is disabled
+ */
+bool
+write(const ndn::util::Logger& logger, ndn::util::LogLevel level, const Encoder& encoder);
+
+/**
+ * @brief Format binary payload as text
+ *
+ * Malformed or unknown records are reported in the returned text instead of throwing.
+ */
+std::string
+format(const uint8_t* payload, size_t size);
+
+} // namespace blog
+} // namespace icear
+
+/**
+ * @brief Log with a format from ICEAR_BLOG_FORMATS; arguments are encoded, not formatted
+ *
+ * Must be used in a translation unit with NDN_LOG_INIT, whose logger accessor (getNdnCxxLogger
+ * in ndn-cxx 0.6) provides module name and level.
+ */
+#define ICEAR_BLOG(lvl, fmt, ...) \
+  do { \
+    if (getNdnCxxLogger().isLevelEnabled(::ndn::util::LogLevel::lvl)) { \
+      const auto& icearBlogEncoder = ::icear::blog::encode(::icear::blog::Format::fmt, ##__VA_ARGS__); \
+      if (!::icear::blog::write(getNdnCxxLogger(), ::ndn::util::LogLevel::lvl, icearBlogEncoder)) { \
+        NDN_LOG_##lvl(::icear::blog::format(icearBlogEncoder.data(), icearBlogEncoder.size())); \
+      } \
+    } \
+  } while (false)
+
+#define ICEAR_BLOG_TRACE(fmt, ...) ICEAR_BLOG(TRACE, fmt, ##__VA_ARGS__)
+#define ICEAR_BLOG_DEBUG(fmt, ...) ICEAR_BLOG(DEBUG, fmt, ##__VA_ARGS__)
+#define ICEAR_BLOG_INFO(fmt, ...)  ICEAR_BLOG(INFO,  fmt, ##__VA_ARGS__)
+#define ICEAR_BLOG_WARN(fmt, ...)  ICEAR_BLOG(WARN,  fmt, ##__VA_ARGS__)
+#define ICEAR_BLOG_ERROR(fmt, ...) ICEAR_BLOG(ERROR, fmt, ##__VA_ARGS__)
+
+#endif // ICEAR_BINARY_LOG_HPP
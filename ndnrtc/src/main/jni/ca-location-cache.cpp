@@ -0,0 +1,62 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#include "ca-location-cache.hpp"
+
+#include <ndn-cxx/util/logger.hpp>
+
+namespace ndn {
+namespace ndncert {
+
+NDN_LOG_INIT(ndncert.CaLocationCache);
+
+CaLocationCache::CaLocationCache(size_t capacity)
+  : m_capacity(capacity)
+{
+}
+
+const CaLocation*
+CaLocationCache::find(const std::string& network)
+{
+  auto it = m_index.find(network);
+  if (it == m_index.end()) {
+    ++m_stats.nMisses;
+    return nullptr;
+  }
+  ++m_stats.nHits;
+
+  m_entries.splice(m_entries.begin(), m_entries, it->second);
+  return &it->second->second;
+}
+
+void
+CaLocationCache::insert(const std::string& network, const CaLocation& location)
+{
+  auto it = m_index.find(network);
+  if (it != m_index.end()) {
+    it->second->second = location;
+    m_entries.splice(m_entries.begin(), m_entries, it->second);
+    return;
+  }
+
+  if (m_entries.size() >= m_capacity) {
+    m_index.erase(m_entries.back().first);
+    m_entries.pop_back();
+  }
+  m_entries.emplace_front(network, location);
+  m_index.emplace(network, m_entries.begin());
+  NDN_LOG_TRACE("Cached " << location.caName << " on face " << location.faceId << " for " << network);
+}
+
+void
+CaLocationCache::erase(const std::string& network)
+{
+  auto it = m_index.find(network);
+  if (it == m_index.end()) {
+    return;
+  }
+  m_entries.erase(it->second);
+  m_index.erase(it);
+}
+
+} // namespace ndncert
+} // namespace ndn
@@ -0,0 +1,78 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#ifndef ICEAR_CA_LOCATION_CACHE_HPP
+#define ICEAR_CA_LOCATION_CACHE_HPP
+
+#include <ndn-cxx/security/v2/certificate.hpp>
+#include <ndn-cxx/util/noncopyable.hpp>
+#include <ndn-cxx/util/time.hpp>
+
+#include <list>
+#include <map>
+#include <string>
+
+namespace ndn {
+namespace ndncert {
+
+/**
+ * @brief Where the CA of a network was found last time
+ */
+struct CaLocation
+{
+  Name caName;
+  security::v2::Certificate cert;       ///< pinned: the CA must answer with this key to be reused
+  uint64_t faceId = 0;                  ///< multi-access face the discovery Data came from
+  name::Component discoveryComponent;   ///< distinguishes the CA's discovery Data, may be empty
+  time::nanoseconds rtt{0};             ///< smoothed RTT of the face, zero if not measured
+};
+
+/**
+ * @brief Cache of discovered CAs, keyed by network identifier (e.g., BSSID of the access point)
+ *
+ * When the client comes back to a network, the cached CA can be asked directly over its face,
+ * without registering the discovery prefix on every face and multicasting the discovery Interest.
+ * The least recently used network is evicted once capacity is reached.
+ */
+class CaLocationCache : noncopyable
+{
+public:
+  struct Stats
+  {
+    size_t nHits = 0;
+    size_t nMisses = 0;
+  };
+
+  explicit
+  CaLocationCache(size_t capacity = 32);
+
+  /**
+   * @return CA location of @p network, or nullptr; valid until the cache is modified
+   */
+  const CaLocation*
+  find(const std::string& network);
+
+  void
+  insert(const std::string& network, const CaLocation& location);
+
+  void
+  erase(const std::string& network);
+
+  const Stats&
+  getStats() const
+  {
+    return m_stats;
+  }
+
+private:
+  using Entries = std::list<std::pair<std::string, CaLocation>>; // most recently used first
+
+  const size_t m_capacity;
+  Entries m_entries;
+  std::map<std::string, Entries::iterator> m_index;
+  Stats m_stats;
+};
+
+} // namespace ndncert
+} // namespace ndn
+
+#endif // ICEAR_CA_LOCATION_CACHE_HPP
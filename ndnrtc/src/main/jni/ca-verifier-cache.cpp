@@ -0,0 +1,57 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#include "ca-verifier-cache.hpp"
+
+#include <ndn-cxx/security/verification-helpers.hpp>
+#include <ndn-cxx/util/logger.hpp>
+
+namespace ndn {
+namespace ndncert {
+
+NDN_LOG_INIT(ndncert.CaVerifierCache);
+
+CaVerifierCache::CaVerifierCache(size_t capacity)
+  : m_capacity(capacity)
+{
+}
+
+const security::transform::PublicKey&
+CaVerifierCache::getPublicKey(const security::v2::Certificate& cert)
+{
+  const Name& fullName = cert.getFullName();
+
+  auto it = m_keys.find(fullName);
+  if (it != m_keys.end()) {
+    ++m_stats.nHits;
+    return *it->second;
+  }
+  ++m_stats.nMisses;
+
+  auto key = std::make_unique<security::transform::PublicKey>();
+  const Buffer& keyBits = cert.getPublicKey();
+  key->loadPkcs8(keyBits.data(), keyBits.size());
+
+  if (m_keys.size() >= m_capacity) {
+    m_keys.erase(m_insertionOrder.front());
+    m_insertionOrder.pop_front();
+  }
+  m_insertionOrder.push_back(fullName);
+
+  NDN_LOG_TRACE("Cached public key of " << cert.getName());
+  return *m_keys.emplace(fullName, std::move(key)).first->second;
+}
+
+bool
+CaVerifierCache::verify(const Data& data, const security::v2::Certificate& signer)
+{
+  try {
+    return security::verifySignature(data, getPublicKey(signer));
+  }
+  catch (const std::exception& e) {
+    NDN_LOG_ERROR("Cannot use key of " << signer.getName() << " for verification: " << e.what());
+    return false;
+  }
+}
+
+} // namespace ndncert
+} // namespace ndn
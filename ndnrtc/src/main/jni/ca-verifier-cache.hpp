@@ -0,0 +1,64 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#ifndef ICEAR_CA_VERIFIER_CACHE_HPP
+#define ICEAR_CA_VERIFIER_CACHE_HPP
+
+#include <ndn-cxx/security/transform/public-key.hpp>
+#include <ndn-cxx/security/v2/certificate.hpp>
+
+#include <list>
+#include <map>
+
+namespace ndn {
+namespace ndncert {
+
+/**
+ * @brief Cache of decoded CA public keys for repeated signature checks
+ *
+ * security::verifySignature(data, cert) re-parses the certificate's public key on every call.
+ * The cache decodes each key once and keeps it ready for verification, keyed by the full name
+ * (including implicit digest) of the certificate, so a re-issued certificate under the same name
+ * never hits a stale entry.
+ */
+class CaVerifierCache : noncopyable
+{
+public:
+  struct Stats
+  {
+    size_t nHits = 0;
+    size_t nMisses = 0;
+  };
+
+  explicit
+  CaVerifierCache(size_t capacity = 16);
+
+  /**
+   * @brief Verify that @p data is signed by the key of @p signer
+   */
+  bool
+  verify(const Data& data, const security::v2::Certificate& signer);
+
+  /**
+   * @brief Get decoded public key of @p cert, decoding it on first use
+   * @throw security::transform::PublicKey::Error the certificate carries a malformed key
+   */
+  const security::transform::PublicKey&
+  getPublicKey(const security::v2::Certificate& cert);
+
+  const Stats&
+  getStats() const
+  {
+    return m_stats;
+  }
+
+private:
+  const size_t m_capacity;
+  std::map<Name, std::unique_ptr<security::transform::PublicKey>> m_keys;
+  std::list<Name> m_insertionOrder;
+  Stats m_stats;
+};
+
+} // namespace ndncert
+} // namespace ndn
+
+#endif // ICEAR_CA_VERIFIER_CACHE_HPP
@@ -0,0 +1,399 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#include "face-capture.hpp"
+
+#include <ndn-cxx/data.hpp>
+#include <ndn-cxx/interest.hpp>
+#include <ndn-cxx/lp/packet.hpp>
+#include <ndn-cxx/util/logger.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+#include <limits>
+
+namespace ndn {
+namespace ndncert {
+
+NDN_LOG_INIT(ndncert.FaceCapture);
+
+static const uint32_t MAGIC = 0x43464349; // 'ICFC'
+static const uint32_t VERSION = 1;
+static const size_t FILE_HEADER_SIZE = 8;
+static const size_t RECORD_HEADER_SIZE = 5;
+
+/**
+ * @return network layer packet carried in @p packet, or an empty block for IDLE packets
+ */
+static Block
+getNetworkPacket(const lp::Packet& packet)
+{
+  if (!packet.has<lp::FragmentField>()) {
+    return Block();
+  }
+  auto fragment = packet.get<lp::FragmentField>();
+  return Block(&*fragment.first, std::distance(fragment.first, fragment.second));
+}
+
+/**
+ * @return name of the Interest in @p wire, or an empty name if it's not an Interest
+ */
+static Name
+getInterestName(const Block& wire)
+{
+  try {
+    lp::Packet packet(wire);
+    Block netPacket = getNetworkPacket(packet);
+    if (netPacket.type() == tlv::Interest && !packet.has<lp::NackField>()) {
+      return Interest(netPacket).getName();
+    }
+  }
+  catch (const tlv::Error&) {
+  }
+  return Name();
+}
+
+/**
+ * @return whether @p name is an NDNCERT request (`<ca-prefix>/CA/_<COMMAND>/...`)
+ */
+static bool
+isNdncertInterestName(const Name& name)
+{
+  static const name::Component CA_COMPONENT("CA");
+  for (size_t i = 0; i + 1 < name.size(); ++i) {
+    if (name[i] == CA_COMPONENT && name[i + 1].value_size() > 1 && name[i + 1].value()[0] == '_') {
+      return true;
+    }
+  }
+  return false;
+}
+
+CaptureTransport::CaptureTransport(shared_ptr<Transport> transport, const std::string& path)
+  : m_transport(std::move(transport))
+  , m_os(path, std::ios::binary | std::ios::trunc)
+  , m_lastRecord(time::steady_clock::now())
+{
+  if (!m_os) {
+    NDN_THROW(Error("Cannot create face capture " + path));
+  }
+  m_os.write(reinterpret_cast<const char*>(&MAGIC), sizeof(MAGIC));
+  m_os.write(reinterpret_cast<const char*>(&VERSION), sizeof(VERSION));
+}
+
+CaptureTransport::~CaptureTransport()
+{
+  m_os.flush();
+}
+
+void
+CaptureTransport::connect(boost::asio::io_service& ioService, const ReceiveCallback& receiveCallback)
+{
+  Transport::connect(ioService, receiveCallback);
+  m_transport->connect(ioService, [this] (const Block& wire) {
+      record(face_capture::INCOMING, wire.wire(), wire.size());
+      m_receiveCallback(wire);
+    });
+  m_isConnected = true;
+}
+
+void
+CaptureTransport::close()
+{
+  m_transport->close();
+  m_isConnected = false;
+  m_isReceiving = false;
+  m_os.flush();
+}
+
+void
+CaptureTransport::send(const Block& wire)
+{
+  record(face_capture::OUTGOING, wire.wire(), wire.size());
+  m_transport->send(wire);
+}
+
+void
+CaptureTransport::send(const Block& header, const Block& payload)
+{
+  std::vector<uint8_t> wire(header.wire(), header.wire() + header.size());
+  wire.insert(wire.end(), payload.wire(), payload.wire() + payload.size());
+  record(face_capture::OUTGOING, wire.data(), wire.size());
+  m_transport->send(header, payload);
+}
+
+void
+CaptureTransport::pause()
+{
+  m_transport->pause();
+  m_isReceiving = false;
+}
+
+void
+CaptureTransport::resume()
+{
+  m_transport->resume();
+  m_isReceiving = true;
+}
+
+void
+CaptureTransport::record(face_capture::Direction direction, const uint8_t* wire, size_t size)
+{
+  auto now = time::steady_clock::now();
+  auto delay = time::duration_cast<time::microseconds>(now - m_lastRecord).count();
+  m_lastRecord = now;
+
+  uint8_t direction8 = direction;
+  uint32_t delay32 = static_cast<uint32_t>(std::min<int64_t>(delay, std::numeric_limits<uint32_t>::max()));
+  m_os.write(reinterpret_cast<const char*>(&direction8), sizeof(direction8));
+  m_os.write(reinterpret_cast<const char*>(&delay32), sizeof(delay32));
+  m_os.write(reinterpret_cast<const char*>(wire), size);
+}
+
+ReplayTransport::ReplayTransport(const std::string& path, Timing timing)
+  : m_timing(timing)
+{
+  std::ifstream is(path, std::ios::binary);
+  if (!is) {
+    NDN_THROW(Error("Cannot open face capture " + path));
+  }
+  auto buffer = make_shared<Buffer>(std::istreambuf_iterator<char>(is), std::istreambuf_iterator<char>());
+
+  uint32_t magic = 0;
+  uint32_t version = 0;
+  if (buffer->size() >= FILE_HEADER_SIZE) {
+    std::memcpy(&magic, buffer->data(), sizeof(magic));
+    std::memcpy(&version, buffer->data() + sizeof(magic), sizeof(version));
+  }
+  if (magic != MAGIC || version != VERSION) {
+    NDN_THROW(Error(path + " is not a face capture"));
+  }
+
+  time::nanoseconds sinceLastOutgoing(0);
+  for (size_t offset = FILE_HEADER_SIZE; offset < buffer->size();) {
+    if (offset + RECORD_HEADER_SIZE > buffer->size()) {
+      NDN_THROW(Error("Truncated record at offset " + to_string(offset) + " of " + path));
+    }
+    uint8_t direction = (*buffer)[offset];
+    uint32_t delay = 0;
+    std::memcpy(&delay, buffer->data() + offset + 1, sizeof(delay));
+    offset += RECORD_HEADER_SIZE;
+
+    bool isOk = false;
+    Block wire;
+    std::tie(isOk, wire) = Block::fromBuffer(buffer, offset);
+    if (!isOk) {
+      NDN_THROW(Error("Malformed packet at offset " + to_string(offset) + " of " + path));
+    }
+    offset += wire.size();
+
+    sinceLastOutgoing += time::microseconds(delay);
+    if (direction == face_capture::OUTGOING) {
+      m_capturedInterestNames.push_back(getInterestName(wire));
+      sinceLastOutgoing = time::nanoseconds(0);
+    }
+    else {
+      m_incoming.push_back({wire, m_capturedInterestNames.size(), sinceLastOutgoing});
+    }
+  }
+
+  // everything from the first NDNCERT request on is signed or encrypted for the captured run's
+  // keys, so the client would reject it; replay ends where NDNCERT starts
+  auto firstNdncert = std::find_if(m_capturedInterestNames.begin(), m_capturedInterestNames.end(),
+                                   &isNdncertInterestName);
+  if (firstNdncert != m_capturedInterestNames.end()) {
+    size_t nOutgoing = std::distance(m_capturedInterestNames.begin(), firstNdncert) + 1;
+    NDN_LOG_DEBUG("Replaying up to " << *firstNdncert << " (outgoing packet " << nOutgoing << ")");
+    m_capturedInterestNames.resize(nOutgoing);
+    m_incoming.erase(std::find_if(m_incoming.begin(), m_incoming.end(),
+                                  [nOutgoing] (const Incoming& incoming) {
+                                    return incoming.nPrecedingOutgoing >= nOutgoing;
+                                  }),
+                     m_incoming.end());
+  }
+
+  NDN_LOG_DEBUG("Loaded " << m_capturedInterestNames.size() << " outgoing and "
+                << m_incoming.size() << " incoming packets from " << path);
+}
+
+void
+ReplayTransport::connect(boost::asio::io_service& ioService, const ReceiveCallback& receiveCallback)
+{
+  Transport::connect(ioService, receiveCallback);
+  m_isConnected = true;
+  m_timer = make_unique<boost::asio::steady_timer>(ioService);
+  m_sentAt.assign(1, time::steady_clock::now());
+
+  if (m_incoming.empty()) {
+    ioService.post([this] { onFinished(); });
+  }
+  scheduleDelivery();
+}
+
+void
+ReplayTransport::close()
+{
+  if (m_timer != nullptr) {
+    m_timer->cancel();
+  }
+  m_isDeliveryScheduled = false;
+  m_isConnected = false;
+  m_isReceiving = false;
+}
+
+void
+ReplayTransport::send(const Block& wire)
+{
+  size_t index = m_sentAt.size() - 1;
+  m_sentAt.push_back(time::steady_clock::now());
+
+  if (index < m_capturedInterestNames.size() && !m_capturedInterestNames[index].empty()) {
+    Name sentName = getInterestName(wire);
+    if (!sentName.empty() && sentName != m_capturedInterestNames[index]) {
+      m_renames[m_capturedInterestNames[index]] = sentName;
+    }
+  }
+
+  scheduleDelivery();
+}
+
+void
+ReplayTransport::send(const Block& header, const Block& payload)
+{
+  std::vector<uint8_t> wire(header.wire(), header.wire() + header.size());
+  wire.insert(wire.end(), payload.wire(), payload.wire() + payload.size());
+  send(Block(wire.data(), wire.size()));
+}
+
+void
+ReplayTransport::pause()
+{
+  m_isReceiving = false;
+}
+
+void
+ReplayTransport::resume()
+{
+  m_isReceiving = true;
+  scheduleDelivery();
+}
+
+void
+ReplayTransport::scheduleDelivery()
+{
+  if (m_isDeliveryScheduled || !m_isReceiving || m_nextIncoming >= m_incoming.size()) {
+    return;
+  }
+
+  const Incoming& incoming = m_incoming[m_nextIncoming];
+  if (incoming.nPrecedingOutgoing >= m_sentAt.size()) {
+    // the client hasn't got that far yet
+    return;
+  }
+
+  m_isDeliveryScheduled = true;
+  if (m_timing == Timing::FULL_SPEED) {
+    m_ioService->post([this] {
+        m_isDeliveryScheduled = false;
+        deliverReady();
+      });
+    return;
+  }
+
+  auto due = m_sentAt[incoming.nPrecedingOutgoing] + incoming.delay;
+  auto wait = std::max(time::nanoseconds(0), time::duration_cast<time::nanoseconds>(due - time::steady_clock::now()));
+  m_timer->expires_from_now(std::chrono::nanoseconds(wait.count()));
+  m_timer->async_wait([this] (const boost::system::error_code& error) {
+      if (error) {
+        return;
+      }
+      m_isDeliveryScheduled = false;
+      deliverReady();
+    });
+}
+
+void
+ReplayTransport::deliverReady()
+{
+  while (m_isReceiving && m_nextIncoming < m_incoming.size()) {
+    const Incoming& incoming = m_incoming[m_nextIncoming];
+    if (incoming.nPrecedingOutgoing >= m_sentAt.size()) {
+      break;
+    }
+    if (m_timing == Timing::ORIGINAL &&
+        m_sentAt[incoming.nPrecedingOutgoing] + incoming.delay > time::steady_clock::now()) {
+      break;
+    }
+
+    ++m_nextIncoming;
+    m_receiveCallback(renameToSentInterest(incoming.wire));
+
+    if (m_nextIncoming == m_incoming.size()) {
+      NDN_LOG_DEBUG("Replay finished after " << m_sentAt.size() - 1 << " outgoing packets");
+      onFinished();
+      return;
+    }
+  }
+
+  scheduleDelivery();
+}
+
+Block
+ReplayTransport::renameToSentInterest(const Block& wire) const
+{
+  if (m_renames.empty()) {
+    return wire;
+  }
+
+  try {
+    lp::Packet packet(wire);
+    Block netPacket = getNetworkPacket(packet);
+
+    auto findName = [this] (const Name& name, Name& newName) {
+      auto rename = m_renames.find(name);
+      if (rename != m_renames.end()) {
+        newName = rename->second;
+        return true;
+      }
+      for (const auto& entry : m_renames) {
+        if (entry.first.isPrefixOf(name)) {
+          newName = Name(entry.second).append(name.getSubName(entry.first.size()));
+          return true;
+        }
+      }
+      return false;
+    };
+
+    Name newName;
+    Block renamed;
+    if (netPacket.type() == tlv::Data) {
+      Data data(netPacket);
+      if (!findName(data.getName(), newName)) {
+        return wire;
+      }
+      // signature no longer verifies; replay exercises the client's processing, not its trust
+      data.setName(newName);
+      renamed = data.wireEncode();
+    }
+    else if (netPacket.type() == tlv::Interest && packet.has<lp::NackField>()) {
+      Interest interest(netPacket);
+      if (!findName(interest.getName(), newName)) {
+        return wire;
+      }
+      interest.setName(newName);
+      renamed = interest.wireEncode();
+    }
+    else {
+      return wire;
+    }
+
+    packet.set<lp::FragmentField>(std::make_pair(renamed.begin(), renamed.end()));
+    return packet.wireEncode();
+  }
+  catch (const tlv::Error& e) {
+    NDN_LOG_DEBUG("Cannot rename replayed packet: " << e.what());
+    return wire;
+  }
+}
+
+} // namespace ndncert
+} // namespace ndn
@@ -0,0 +1,167 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#ifndef ICEAR_FACE_CAPTURE_HPP
+#define ICEAR_FACE_CAPTURE_HPP
+
+#include <ndn-cxx/name.hpp>
+#include <ndn-cxx/transport/transport.hpp>
+#include <ndn-cxx/util/signal.hpp>
+#include <ndn-cxx/util/time.hpp>
+
+#include <boost/asio/steady_timer.hpp>
+
+#include <fstream>
+#include <map>
+#include <vector>
+
+namespace ndn {
+namespace ndncert {
+
+/**
+ * @brief Capture of packets exchanged between the client and the forwarder
+ *
+ * File layout (host byte order):
+ *
+ *     uint32 magic ('ICFC'), uint32 version
+ *     Record*
+ *
+ *     Record = uint8  direction  ; OUTGOING (client to forwarder) or INCOMING
+ *              uint32 delay      ; microseconds since the previous record, saturated
+ *              TLV               ; packet as it was on the wire (LpPacket or bare Interest/Data)
+ */
+namespace face_capture {
+
+enum Direction : uint8_t {
+  OUTGOING = 0,
+  INCOMING = 1
+};
+
+} // namespace face_capture
+
+/**
+ * @brief Transport that records every packet passing through the wrapped transport
+ */
+class CaptureTransport : public Transport
+{
+public:
+  /**
+   * @throw Transport::Error capture file cannot be created
+   */
+  CaptureTransport(shared_ptr<Transport> transport, const std::string& path);
+
+  ~CaptureTransport() override;
+
+  void
+  connect(boost::asio::io_service& ioService, const ReceiveCallback& receiveCallback) override;
+
+  void
+  close() override;
+
+  void
+  send(const Block& wire) override;
+
+  void
+  send(const Block& header, const Block& payload) override;
+
+  void
+  pause() override;
+
+  void
+  resume() override;
+
+private:
+  void
+  record(face_capture::Direction direction, const uint8_t* wire, size_t size);
+
+private:
+  shared_ptr<Transport> m_transport;
+  std::ofstream m_os;
+  time::steady_clock::TimePoint m_lastRecord;
+};
+
+/**
+ * @brief Transport that plays back a capture instead of talking to a forwarder
+ *
+ * An incoming packet is delivered only after the client has sent as many packets as preceded it
+ * in the capture.  With original timing, it is delayed by the same amount after the last of them
+ * as it was when captured; at full speed it is delivered right away.
+ *
+ * The client's signed and parameterized Interests differ between runs, so Data and Nacks are
+ * renamed to the Interest the client sent at the same position in the exchange.
+ *
+ * Only the part of the capture before the first NDNCERT request is played back: forwarder
+ * management, route registration and CA discovery.  NDNCERT responses are signed over the
+ * captured Interest names and carry codes encrypted to the captured run's requester key, so the
+ * client could not get past the first of them anyway.
+ */
+class ReplayTransport : public Transport
+{
+public:
+  enum class Timing {
+    ORIGINAL,
+    FULL_SPEED
+  };
+
+  /**
+   * @throw Transport::Error capture file cannot be read or is malformed
+   */
+  ReplayTransport(const std::string& path, Timing timing);
+
+  void
+  connect(boost::asio::io_service& ioService, const ReceiveCallback& receiveCallback) override;
+
+  void
+  close() override;
+
+  void
+  send(const Block& wire) override;
+
+  void
+  send(const Block& header, const Block& payload) override;
+
+  void
+  pause() override;
+
+  void
+  resume() override;
+
+public:
+  /**
+   * @brief Fires after the last captured incoming packet has been delivered
+   */
+  util::Signal<ReplayTransport> onFinished;
+
+private:
+  struct Incoming
+  {
+    Block wire;
+    size_t nPrecedingOutgoing;
+    time::nanoseconds delay; ///< since the last preceding outgoing packet (or the start)
+  };
+
+  void
+  scheduleDelivery();
+
+  void
+  deliverReady();
+
+  Block
+  renameToSentInterest(const Block& wire) const;
+
+private:
+  Timing m_timing;
+  std::vector<Incoming> m_incoming;
+  std::vector<Name> m_capturedInterestNames; ///< per outgoing packet, empty if not an Interest
+  size_t m_nextIncoming = 0;
+
+  std::vector<time::steady_clock::TimePoint> m_sentAt; ///< [0] is the start of replay
+  std::map<Name, Name> m_renames; ///< captured Interest name => name sent during replay
+
+  unique_ptr<boost::asio::steady_timer> m_timer;
+  bool m_isDeliveryScheduled = false;
+};
+
+} // namespace ndncert
+} // namespace ndn
+
+#endif // ICEAR_FACE_CAPTURE_HPP
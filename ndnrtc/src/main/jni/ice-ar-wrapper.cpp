@@ -1,28 +1,18 @@
 /* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
 
 #include "ice-ar-wrapper.hpp"
-#include "mobile-terminal.hpp"
+#include "icear-core.h"
 
 #include <map>
+#include <memory>
+#include <mutex>
 #include <string>
-#include <thread>
+#include <vector>
 
-#include <ndn-cxx/security/key-chain.hpp>
 #include <ndn-cxx/util/exception.hpp>
 #include <ndn-cxx/util/logger.hpp>
-#include <ndn-cxx/util/logging.hpp>
 
-#include <boost/log/attributes.hpp>
-#include <boost/log/sources/record_ostream.hpp>
-#include <boost/log/core.hpp>
-#include <boost/log/expressions.hpp>
-#include <boost/log/sinks.hpp>
-#include <boost/log/sources/logger.hpp>
-#include <boost/log/utility/setup.hpp>
-#include <boost/log/sources/severity_logger.hpp>
-#include <boost/log/expressions/keyword.hpp>
-
-NDN_LOG_INIT(ndncert.Runner);
+NDN_LOG_INIT(ndncert.JniWrapper);
 
 std::map<std::string, std::string>
 getParams(JNIEnv* env, jobject jParams)
@@ -64,16 +54,6 @@ getParams(JNIEnv* env, jobject jParams)
   return params;
 }
 
-namespace icear {
-
-static std::thread g_thread;
-static std::mutex g_mutex;
-static std::unique_ptr<ndn::ndncert::MobileTerminal> g_runner;
-static std::unique_ptr<ndn::KeyChain> g_keyChain;
-static std::string g_ssid = "";
-
-} // namespace icear
-
 void init(JNIEnv* env);
 
 JavaVM* g_vm;
@@ -162,176 +142,224 @@ private:
   T m_localRef;
 };
 
-JNIEXPORT void JNICALL
-Java_net_named_1data_ice_1ar_NdnRtcWrapper_start(JNIEnv* env, jclass, jobject jParams, jobject notify)
+/**
+ * @brief Java StartStopNotify object passed to start() and restart(); context of icear_callbacks
+ */
+class JavaNotify
 {
-  init(env); // logging facilities, though not sure it gonna work
-
-  auto params = getParams(env, jParams);
-  // set/update HOME environment variable
-  ::setenv("HOME", params["homePath"].c_str(), true);
-
-  // set NDN_CLIENT_TRANSPORT to ensure connection TCP socket (unix doesn't work on Android)
-  ::setenv("NDN_CLIENT_TRANSPORT", "tcp4://127.0.0.1:6363", true);
-
-  ::setenv("NDN_CLIENT_PIB", "pib-memory", true);
-  ::setenv("NDN_CLIENT_TPM", "tpm-memory", true);
+public:
+  JavaNotify(JNIEnv* env, jobject notify)
+    : m_object(env, notify)
+  {
+    LocalRef<jclass> jcNotify(env, env->GetObjectClass(notify));
+    m_onStarted = env->GetMethodID(jcNotify.get(), "onStarted", "()V");
+    m_onStopped = env->GetMethodID(jcNotify.get(), "onStopped", "()V");
+    if (m_onStarted == nullptr || m_onStopped == nullptr) {
+      NDN_THROW(std::logic_error("Notification methods not found, abort"));
+    }
 
-  if (params.find("log") != params.end()) {
-    ndn::util::Logging::setLevel(params["log"]);
+    m_getWifi = env->GetMethodID(jcNotify.get(), "getWifi", "()Ljava/lang/String;");
+    if (m_getWifi == nullptr) {
+      NDN_THROW(std::logic_error("jcNotifyGetWifi method not found, abort"));
+    }
   }
-  else {
-    ndn::util::Logging::setLevel("*=ALL");
+
+  /**
+   * @brief Callbacks calling this object; the terminal deletes it through release
+   */
+  icear_callbacks
+  toCallbacks()
+  {
+    icear_callbacks callbacks = {};
+    callbacks.context = this;
+    callbacks.on_started = [] (void* self) {
+      static_cast<JavaNotify*>(self)->call(static_cast<JavaNotify*>(self)->m_onStarted);
+    };
+    callbacks.on_stopped = [] (void* self) {
+      static_cast<JavaNotify*>(self)->call(static_cast<JavaNotify*>(self)->m_onStopped);
+    };
+    callbacks.get_network = [] (void* self) {
+      return static_cast<JavaNotify*>(self)->getWifi();
+    };
+    callbacks.release = [] (void* self) {
+      delete static_cast<JavaNotify*>(self);
+    };
+    return callbacks;
   }
 
-  NDN_LOG_TRACE("Will process with app path: " << params.find("homePath")->second.c_str());
+private:
+  void
+  call(jmethodID method)
+  {
+    ScopedEnv env;
+    env.get()->CallVoidMethod(m_object.get(), method);
+  }
 
-  std::lock_guard<std::mutex> lk(icear::g_mutex);
-  if (icear::g_runner.get() != nullptr) {
-    // prevent any double starts
-    NDN_LOG_TRACE("Runner already created, do nothing");
-    return;
+  const char*
+  getWifi()
+  {
+    ScopedEnv env;
+    LocalRef<jstring> jssid(env.get(), (jstring)env.get()->CallObjectMethod(m_object.get(), m_getWifi));
+    const char* ssid = env.get()->GetStringUTFChars(jssid.get(), nullptr);
+    m_network = ssid;
+    env.get()->ReleaseStringUTFChars(jssid.get(), ssid);
+
+    if (m_network == "02:00:00:00:00:00") {
+      NDN_LOG_ERROR("Unknown SSID (location permission denied)");
+      m_network.clear();
+    }
+    return m_network.c_str();
   }
 
-  auto notifyGlobal = std::make_shared<GlobalRef<jobject>>(env, notify);
+private:
+  GlobalRef<jobject> m_object;
+  jmethodID m_onStarted;
+  jmethodID m_onStopped;
+  jmethodID m_getWifi;
+  std::string m_network; // returned by getWifi() until its next call
+};
 
-  auto jcNotify = env->GetObjectClass(notifyGlobal->get());
-  auto jcNotifyOnStart = env->GetMethodID(jcNotify, "onStarted", "()V");
-  auto jcNotifyOnStop = env->GetMethodID(jcNotify, "onStopped", "()V");
-  if (jcNotifyOnStart == nullptr || jcNotifyOnStop == nullptr) {
-    NDN_THROW(std::logic_error("Notification methods not found, abort"));
-  }
+static icear_terminal*
+getTerminal()
+{
+  // one terminal per process, as the Java API has no handle for it
+  static icear_terminal* terminal = icear_terminal_create();
+  return terminal;
+}
 
-  auto jcNotifyGetWifi = env->GetMethodID(jcNotify, "getWifi", "()Ljava/lang/String;");
-  if (jcNotifyGetWifi == nullptr) {
-    NDN_THROW(std::logic_error("jcNotifyGetWifi method not found, abort"));
+/**
+ * @brief Start parameters in the form of the C API; points into @p params
+ */
+static std::vector<icear_param>
+toCParams(const std::map<std::string, std::string>& params)
+{
+  std::vector<icear_param> cParams;
+  for (const auto& param : params) {
+    cParams.push_back({param.first.c_str(), param.second.c_str()});
   }
+  return cParams;
+}
+
+JNIEXPORT void JNICALL
+Java_net_named_1data_ice_1ar_NdnRtcWrapper_start(JNIEnv* env, jclass, jobject jParams, jobject notify)
+{
+  init(env); // logging facilities, though not sure it gonna work
 
-  icear::g_thread = std::thread([params, notifyGlobal, jcNotifyOnStart, jcNotifyOnStop, jcNotifyGetWifi] {
-      try {
-        ScopedEnv env;
-        auto getSsidFromAndroid = [&env, jcNotifyGetWifi, notifyGlobal] {
-          // jcNotifyGetWifi
-          jstring jssid = (jstring)env.get()->CallObjectMethod(notifyGlobal->get(), jcNotifyGetWifi);
-          const char* ssid = env.get()->GetStringUTFChars(jssid, nullptr);
-          std::string retval = ssid;
-          env.get()->ReleaseStringUTFChars(jssid, ssid);
-          return retval;
-        };
-
-        {
-          std::lock_guard<std::mutex> lk(icear::g_mutex);
-          if (icear::g_runner.get() != nullptr) {
-            // now really prevent double starts
-            NDN_LOG_TRACE("Runner already created, do nothing");
-            return;
-          }
-
-          icear::g_ssid = getSsidFromAndroid();
-          if (icear::g_ssid == "02:00:00:00:00:00") {
-            NDN_LOG_ERROR("Unknown SSID (location permission denied)");
-          }
-          else {
-            NDN_LOG_INFO("Connected SSID WiFi: " << icear::g_ssid);
-          }
-
-          if (icear::g_keyChain == nullptr) {
-            icear::g_keyChain = std::make_unique<ndn::KeyChain>();
-          }
-
-          icear::g_runner = std::make_unique<ndn::ndncert::MobileTerminal>(*icear::g_keyChain, [&getSsidFromAndroid] {
-              auto ssid = getSsidFromAndroid();
-              if (ssid == "02:00:00:00:00:00") {
-                NDN_LOG_ERROR("Unknown SSID (location permission denied)");
-                NDN_LOG_DEBUG("Assume re-connected to a new WiFi");
-                return false;
-              }
-              if (ssid != icear::g_ssid) {
-                icear::g_ssid = ssid;
-                NDN_LOG_DEBUG("Re-connected to a new SSID WiFi: " << icear::g_ssid);
-                return false;
-              }
-              else {
-                return true;
-              }
-            });
-        }
-
-        env.get()->CallVoidMethod(notifyGlobal->get(), jcNotifyOnStart);
-
-        NDN_LOG_INFO("NDNCERT + AP monitoring started");
-        icear::g_runner->doStart();
-
-        {
-          std::lock_guard<std::mutex> lk(icear::g_mutex);
-          icear::g_runner.reset();
-        }
-
-        NDN_LOG_INFO("NDNCERT + AP monitoring terminated");
-        env.get()->CallVoidMethod(notifyGlobal->get(), jcNotifyOnStop);
-      } catch (const std::exception& e) {
-        NDN_LOG_ERROR(e.what());
-      }
-    });
-  icear::g_thread.detach();
+  auto params = getParams(env, jParams);
+  auto cParams = toCParams(params);
+  auto callbacks = (new JavaNotify(env, notify))->toCallbacks();
+  icear_terminal_start(getTerminal(), cParams.data(), cParams.size(), &callbacks);
 }
 
 JNIEXPORT void JNICALL
 Java_net_named_1data_ice_1ar_NdnRtcWrapper_stop(JNIEnv*, jclass)
 {
-  {
-    std::lock_guard<std::mutex> lk(icear::g_mutex);
-    if (icear::g_runner.get() != nullptr) {
-      icear::g_runner->doStop();
-    }
-  }
+  icear_terminal_stop(getTerminal());
 }
 
-std::list<std::function<void(JNIEnv* env, const std::string& module, const std::string& severity,
-                             const std::string& message)>> g_callbacks;
+JNIEXPORT void JNICALL
+Java_net_named_1data_ice_1ar_NdnRtcWrapper_restart(JNIEnv* env, jclass, jobject jParams, jobject notify)
+{
+  init(env);
+
+  auto params = getParams(env, jParams);
+  auto cParams = toCParams(params);
+  auto callbacks = (new JavaNotify(env, notify))->toCallbacks();
+  icear_terminal_restart(getTerminal(), cParams.data(), cParams.size(), &callbacks);
+}
+
+/**
+ * @brief Java object receiving native log messages through addMessageFromNative()
+ */
+struct LogSubscriber
+{
+  std::shared_ptr<GlobalRef<jobject>> logger;
+  jmethodID addMessage;
+};
+
+using LogSubscribers = std::vector<LogSubscriber>;
+
+// Copy-on-write list of subscribers: the log callback takes the current snapshot with one atomic
+// load and no lock, while attach and detach (serialized by g_logSubscribersMutex) publish a
+// modified copy.  A detached subscriber lives until the last log call that still sees it returns.
+static std::shared_ptr<const LogSubscribers> g_logSubscribers = std::make_shared<LogSubscribers>();
+static std::mutex g_logSubscribersMutex;
+// to the core's log while any logger is attached, as binary log mode formats records for it
+static uint64_t g_logSubscription = 0;
+
+static void
+onLogRecord(void*, const char* module, const char* severity, const char* message);
 
 JNIEXPORT void JNICALL
-Java_net_named_1data_ice_1ar_NdnRtcWrapper_attach(JNIEnv* env, jclass, jobject logcat)
+Java_net_named_1data_ice_1ar_NdnRtcWrapper_attach(JNIEnv* env, jclass, jobject logger)
 {
   init(env);
 
-  auto logcatGlobal = std::make_shared<GlobalRef<jobject>>(env, logcat);
+  std::lock_guard<std::mutex> lock(g_logSubscribersMutex);
+  auto current = std::atomic_load(&g_logSubscribers);
+  for (const auto& subscriber : *current) {
+    if (env->IsSameObject(subscriber.logger->get(), logger)) {
+      return; // already attached, e.g., fragment re-created on rotation
+    }
+  }
 
-  auto jcLogcatFragment = env->GetObjectClass(logcatGlobal->get());
-  auto jcLogcatFragmentAddMessageFromNative = env->GetMethodID(jcLogcatFragment,
-                                                               "addMessageFromNative", "(Ljava/lang/String;Ljava/lang/String;Ljava/lang/String;)V");
+  LogSubscriber subscriber;
+  subscriber.logger = std::make_shared<GlobalRef<jobject>>(env, logger);
+  subscriber.addMessage = env->GetMethodID(LocalRef<jclass>(env, env->GetObjectClass(logger)).get(),
+                                           "addMessageFromNative",
+                                           "(Ljava/lang/String;Ljava/lang/String;Ljava/lang/String;)V");
 
-  g_callbacks.push_back([logcatGlobal, jcLogcatFragmentAddMessageFromNative]
-                        (JNIEnv* genv, const std::string& module, const std::string& severity, const std::string& message) mutable {
+  auto updated = std::make_shared<LogSubscribers>(*current);
+  updated->push_back(std::move(subscriber));
+  std::atomic_store(&g_logSubscribers, std::shared_ptr<const LogSubscribers>(std::move(updated)));
 
-      genv->CallVoidMethod(logcatGlobal->get(), jcLogcatFragmentAddMessageFromNative,
-                           LocalRef<jstring>(genv, genv->NewStringUTF(module.c_str())).get(),
-                           LocalRef<jstring>(genv, genv->NewStringUTF(severity.c_str())).get(),
-                           LocalRef<jstring>(genv, genv->NewStringUTF(message.c_str())).get());
-    });
+  if (g_logSubscription == 0) {
+    g_logSubscription = icear_log_subscribe(&onLogRecord, nullptr);
+  }
 }
 
 JNIEXPORT void JNICALL
-Java_net_named_1data_ice_1ar_NdnRtcWrapper_detach(JNIEnv* env, jclass, jobject logcat)
+Java_net_named_1data_ice_1ar_NdnRtcWrapper_detach(JNIEnv* env, jclass, jobject logger)
 {
-  g_callbacks.clear();
+  std::lock_guard<std::mutex> lock(g_logSubscribersMutex);
+  auto current = std::atomic_load(&g_logSubscribers);
+
+  auto updated = std::make_shared<LogSubscribers>();
+  for (const auto& subscriber : *current) {
+    if (!env->IsSameObject(subscriber.logger->get(), logger)) {
+      updated->push_back(subscriber);
+    }
+  }
+  if (updated->size() == current->size()) {
+    return;
+  }
+  bool isLast = updated->empty();
+  std::atomic_store(&g_logSubscribers, std::shared_ptr<const LogSubscribers>(std::move(updated)));
+
+  if (isLast && g_logSubscription != 0) {
+    icear_log_unsubscribe(g_logSubscription);
+    g_logSubscription = 0;
+  }
 }
 
-struct android_sink_backend : public boost::log::sinks::basic_sink_backend<boost::log::sinks::concurrent_feeding>
+static void
+onLogRecord(void*, const char* module, const char* severity, const char* message)
 {
-  void
-  consume(const boost::log::record_view& rec)
-  {
-    ScopedEnv genv;
+  auto subscribers = std::atomic_load(&g_logSubscribers);
+  if (subscribers->empty()) {
+    return;
+  }
 
-    auto msg = rec[boost::log::expressions::smessage].get();
-    auto module = rec[ndn::util::log::module].get();
-    auto level = rec[ndn::util::log::severity].get();
-    for (auto& callback : g_callbacks) {
-      callback(genv.get(), module, boost::lexical_cast<std::string>(level), msg);
-    }
+  ScopedEnv genv;
+  JNIEnv* env = genv.get();
+  LocalRef<jstring> jModule(env, env->NewStringUTF(module));
+  LocalRef<jstring> jSeverity(env, env->NewStringUTF(severity));
+  LocalRef<jstring> jMessage(env, env->NewStringUTF(message));
+  for (const auto& subscriber : *subscribers) {
+    env->CallVoidMethod(subscriber.logger->get(), subscriber.addMessage,
+                        jModule.get(), jSeverity.get(), jMessage.get());
   }
-};
+}
 
 void
 init(JNIEnv* env)
@@ -343,10 +371,56 @@ init(JNIEnv* env)
   isInit = true;
 
   env->GetJavaVM(&g_vm);
+}
 
-  typedef boost::log::sinks::synchronous_sink<android_sink_backend> android_sink;
-  auto sink = boost::make_shared<android_sink>();
+JNIEXPORT jstring JNICALL
+Java_net_named_1data_ice_1ar_NdnRtcWrapper_formatLogRecord(JNIEnv* env, jclass, jbyteArray jPayload)
+{
+  jsize size = env->GetArrayLength(jPayload);
+  std::vector<uint8_t> payload(size);
+  env->GetByteArrayRegion(jPayload, 0, size, reinterpret_cast<jbyte*>(payload.data()));
 
-  boost::log::core::get()->add_sink(sink);
+  std::vector<char> text(icear_format_log_record(payload.data(), payload.size(), nullptr, 0) + 1);
+  icear_format_log_record(payload.data(), payload.size(), text.data(), text.size());
+  return env->NewStringUTF(text.data());
+}
 
+JNIEXPORT jstring JNICALL
+Java_net_named_1data_ice_1ar_NdnRtcWrapper_getStats(JNIEnv* env, jclass)
+{
+  // the stats may grow between the two calls; the second one truncates then
+  std::vector<char> stats(icear_terminal_get_stats(getTerminal(), nullptr, 0) + 1);
+  size_t length = icear_terminal_get_stats(getTerminal(), stats.data(), stats.size());
+  if (length >= stats.size()) {
+    stats.resize(length + 1);
+    icear_terminal_get_stats(getTerminal(), stats.data(), stats.size());
+  }
+  return env->NewStringUTF(stats.data());
+}
+
+JNIEXPORT jbyteArray JNICALL
+Java_net_named_1data_ice_1ar_NdnRtcWrapper_getMetrics(JNIEnv* env, jclass)
+{
+  // metrics are read from the shards directly, without involving the I/O thread
+  std::vector<uint8_t> snapshot(icear_get_metrics(nullptr, 0));
+  icear_get_metrics(snapshot.data(), snapshot.size());
+
+  jbyteArray jSnapshot = env->NewByteArray(snapshot.size());
+  env->SetByteArrayRegion(jSnapshot, 0, snapshot.size(), reinterpret_cast<const jbyte*>(snapshot.data()));
+  return jSnapshot;
+}
+
+JNIEXPORT jobjectArray JNICALL
+Java_net_named_1data_ice_1ar_NdnRtcWrapper_getMetricNames(JNIEnv* env, jclass)
+{
+  std::vector<const char*> names(icear_get_metric_names(nullptr, 0));
+  icear_get_metric_names(names.data(), names.size());
+
+  LocalRef<jclass> jcString(env, env->FindClass("java/lang/String"));
+  jobjectArray jNames = env->NewObjectArray(names.size(), jcString.get(), nullptr);
+  for (size_t i = 0; i < names.size(); ++i) {
+    LocalRef<jstring> jName(env, env->NewStringUTF(names[i]));
+    env->SetObjectArrayElement(jNames, i, jName.get());
+  }
+  return jNames;
 }
@@ -26,12 +26,52 @@ Java_net_named_1data_ice_1ar_NdnRtcWrapper_start(JNIEnv*, jclass, jobject, jobje
 JNIEXPORT void JNICALL
 Java_net_named_1data_ice_1ar_NdnRtcWrapper_stop(JNIEnv*, jclass);
 
+/*
+ * Class:     net_named_data_ice_1ar_NdnRtcWrapper
+ * Method:    restart
+ * Signature: (Ljava/util/Map;Lnet/named_data/ice_ar/NdnRtcWrapper/StartStopNotify;)V
+ */
+JNIEXPORT void JNICALL
+Java_net_named_1data_ice_1ar_NdnRtcWrapper_restart(JNIEnv*, jclass, jobject, jobject);
+
 JNIEXPORT void JNICALL
 Java_net_named_1data_ice_1ar_NdnRtcWrapper_attach(JNIEnv* env, jclass, jobject logcat);
 
 JNIEXPORT void JNICALL
 Java_net_named_1data_ice_1ar_NdnRtcWrapper_detach(JNIEnv* env, jclass, jobject logcat);
 
+/*
+ * Class:     net_named_data_ice_1ar_NdnRtcWrapper
+ * Method:    formatLogRecord
+ * Signature: ([B)Ljava/lang/String;
+ */
+JNIEXPORT jstring JNICALL
+Java_net_named_1data_ice_1ar_NdnRtcWrapper_formatLogRecord(JNIEnv* env, jclass, jbyteArray payload);
+
+/*
+ * Class:     net_named_data_ice_1ar_NdnRtcWrapper
+ * Method:    getStats
+ * Signature: ()Ljava/lang/String;
+ */
+JNIEXPORT jstring JNICALL
+Java_net_named_1data_ice_1ar_NdnRtcWrapper_getStats(JNIEnv* env, jclass);
+
+/*
+ * Class:     net_named_data_ice_1ar_NdnRtcWrapper
+ * Method:    getMetrics
+ * Signature: ()[B
+ */
+JNIEXPORT jbyteArray JNICALL
+Java_net_named_1data_ice_1ar_NdnRtcWrapper_getMetrics(JNIEnv* env, jclass);
+
+/*
+ * Class:     net_named_data_ice_1ar_NdnRtcWrapper
+ * Method:    getMetricNames
+ * Signature: ()[Ljava/lang/String;
+ */
+JNIEXPORT jobjectArray JNICALL
+Java_net_named_1data_ice_1ar_NdnRtcWrapper_getMetricNames(JNIEnv* env, jclass);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,774 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#include "icear-core.h"
+#include "binary-log.hpp"
+#include "face-capture.hpp"
+#include "log-ring.hpp"
+#include "metrics.hpp"
+#include "mobile-terminal.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <iomanip>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <ndn-cxx/security/key-chain.hpp>
+#include <ndn-cxx/transport/tcp-transport.hpp>
+#include <ndn-cxx/util/logger.hpp>
+#include <ndn-cxx/util/logging.hpp>
+
+#include <boost/log/core.hpp>
+#include <boost/log/expressions.hpp>
+#include <boost/log/sinks.hpp>
+#include <boost/make_shared.hpp>
+
+NDN_LOG_INIT(ndncert.Runner);
+
+namespace icear {
+
+using Params = std::map<std::string, std::string>;
+
+// never destroyed: logging may happen from any thread until the process exits
+static std::atomic<LogRing*> g_logRing{nullptr};
+
+static void
+openLogRing(const std::string& homePath)
+{
+  if (g_logRing.load() != nullptr) {
+    return;
+  }
+
+  try {
+    g_logRing = new LogRing(homePath + "/" + LogRing::FILE_NAME);
+  }
+  catch (const std::exception& e) {
+    NDN_LOG_ERROR(e.what());
+  }
+}
+
+static std::string
+getParam(const Params& params, const std::string& key)
+{
+  auto value = params.find(key);
+  return value != params.end() ? value->second : "";
+}
+
+/**
+ * @brief Apply process-wide settings of start parameters; called only when a terminal actually
+ *        starts or restarts
+ *
+ * ndn-cxx reads HOME and NDN_CLIENT_* from the environment of the process, which must not change
+ * while other terminals' threads may read it, so the environment is set up once, by the first
+ * start; the log ring is opened in that first homePath as well.  Log levels and log mode are
+ * process-wide in ndn-cxx too: the latest start sets them for all terminals.
+ */
+static void
+configure(const Params& params)
+{
+  static std::once_flag isEnvironmentSet;
+  std::call_once(isEnvironmentSet, [&params] {
+      ::setenv("HOME", getParam(params, "homePath").c_str(), true);
+
+      // TCP connection to the local forwarder (unix socket doesn't work on Android) and in-memory
+      // keys, unless the host environment says otherwise
+      ::setenv("NDN_CLIENT_TRANSPORT", "tcp4://127.0.0.1:6363", false);
+      ::setenv("NDN_CLIENT_PIB", "pib-memory", false);
+      ::setenv("NDN_CLIENT_TPM", "tpm-memory", false);
+
+      openLogRing(getParam(params, "homePath"));
+    });
+
+  // binary mode: records of converted call sites are encoded into the ring and formatted by the viewer
+  blog::setRing(getParam(params, "logMode") == "binary" ? g_logRing.load() : nullptr);
+
+  if (params.find("log") != params.end()) {
+    ndn::util::Logging::setLevel(params.at("log"));
+  }
+  else {
+    ndn::util::Logging::setLevel("*=ALL");
+  }
+
+  NDN_LOG_TRACE("Will process with app path: " << getParam(params, "homePath"));
+}
+
+/**
+ * @brief Transport to the forwarder according to `faceCapture` and `faceReplay` parameters
+ *
+ * `faceCapture=<file>` records all packets exchanged with NFD; `faceReplay=<file>` plays such
+ * capture back instead of connecting to NFD, at original timing or, with `faceReplaySpeed=full`,
+ * as fast as the client can process.  Relative paths are resolved against homePath.
+ * @return nullptr for the default transport
+ */
+static std::shared_ptr<ndn::Transport>
+makeTransport(const Params& params)
+{
+  auto getPath = [&params] (const std::string& path) {
+    if (!path.empty() && path[0] == '/') {
+      return path;
+    }
+    return getParam(params, "homePath") + "/" + path;
+  };
+
+  auto replay = params.find("faceReplay");
+  if (replay != params.end()) {
+    auto speed = params.find("faceReplaySpeed");
+    auto timing = speed != params.end() && speed->second == "full" ?
+                  ndn::ndncert::ReplayTransport::Timing::FULL_SPEED :
+                  ndn::ndncert::ReplayTransport::Timing::ORIGINAL;
+    NDN_LOG_INFO("Replaying forwarder traffic from " << getPath(replay->second));
+    return std::make_shared<ndn::ndncert::ReplayTransport>(getPath(replay->second), timing);
+  }
+
+  auto capture = params.find("faceCapture");
+  if (capture != params.end()) {
+    NDN_LOG_INFO("Capturing forwarder traffic to " << getPath(capture->second));
+    return std::make_shared<ndn::ndncert::CaptureTransport>(ndn::TcpTransport::create(::getenv("NDN_CLIENT_TRANSPORT")),
+                                                            getPath(capture->second));
+  }
+
+  return nullptr;
+}
+
+static bool
+isHedgingEnabled(const Params& params)
+{
+  return getParam(params, "ndncertHedging") == "on";
+}
+
+/**
+ * @brief Check whether @p params and @p other would create the same transport to the forwarder
+ *        and bootstrap on the same interface
+ */
+static bool
+hasSameTransport(const Params& params, const Params& other)
+{
+  for (const char* key : {"homePath", "faceCapture", "faceReplay", "faceReplaySpeed", "interface"}) {
+    auto value = params.find(key);
+    auto otherValue = other.find(key);
+    if ((value == params.end()) != (otherValue == other.end()) ||
+        (value != params.end() && value->second != otherValue->second)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * @brief Copy @p value into @p buffer of @p size octets like snprintf
+ */
+static size_t
+copyString(const std::string& value, char* buffer, size_t size)
+{
+  if (buffer != nullptr && size > 0) {
+    size_t n = std::min(value.size(), size - 1);
+    std::memcpy(buffer, value.data(), n);
+    buffer[n] = '\0';
+  }
+  return value.size();
+}
+
+static void
+writeJsonString(std::ostream& os, const std::string& value)
+{
+  os << '"';
+  for (char c : value) {
+    switch (c) {
+    case '"':  os << "\\\""; break;
+    case '\\': os << "\\\\"; break;
+    case '\n': os << "\\n"; break;
+    case '\t': os << "\\t"; break;
+    default:
+      if (static_cast<unsigned char>(c) < 0x20) {
+        os << "\\u00" << std::hex << std::setw(2) << std::setfill('0')
+           << static_cast<int>(c) << std::dec;
+      }
+      else {
+        os << c;
+      }
+    }
+  }
+  os << '"';
+}
+
+static std::string
+formatStats(const ndn::ndncert::LoopMonitor::Stats& loop, const ndn::ndncert::SessionArena::Stats& arena)
+{
+  std::ostringstream os;
+  os << "{\"loop\":{"
+     << "\"probes\":" << loop.nProbes
+     << ",\"totalLagUs\":" << loop.totalLag.count()
+     << ",\"maxLagUs\":" << loop.maxLag.count()
+     << ",\"lagHistogramMs\":[";
+  for (size_t i = 0; i < loop.lagHistogram.size(); ++i) {
+    os << (i > 0 ? "," : "") << loop.lagHistogram[i];
+  }
+  os << "],\"stalls\":" << loop.nStalls;
+  if (loop.nStalls > 0) {
+    os << ",\"lastStall\":{"
+       << "\"time\":" << ndn::time::toUnixTimestamp(loop.lastStall.time).count()
+       << ",\"durationMs\":" << loop.lastStall.duration.count()
+       << ",\"stack\":";
+    writeJsonString(os, loop.lastStall.stack);
+    os << "}";
+  }
+  os << "},\"lastSessionArena\":{"
+     << "\"allocations\":" << arena.nAllocations
+     << ",\"bytes\":" << arena.nBytes
+     << ",\"heapChunks\":" << arena.nHeapChunks
+     << "}}";
+  return os.str();
+}
+
+/**
+ * @brief Log subscriber of the C API
+ */
+struct LogSubscription
+{
+  uint64_t id;
+  icear_log_callback callback;
+  void* context;
+};
+
+using LogSubscriptions = std::vector<LogSubscription>;
+
+// Copy-on-write list of subscriptions: the sink takes the current snapshot with one atomic load
+// and no lock, while subscribe and unsubscribe (serialized by g_logSubscriptionsMutex) publish a
+// modified copy.
+static std::shared_ptr<const LogSubscriptions> g_logSubscriptions = std::make_shared<LogSubscriptions>();
+static std::mutex g_logSubscriptionsMutex;
+static uint64_t g_lastLogSubscription = 0;
+
+static const std::string&
+getSeverityName(ndn::util::LogLevel level)
+{
+  static const std::string NAMES[] = {"FATAL", "NONE", "ERROR", "WARN", "INFO", "DEBUG", "TRACE"};
+  static const std::string ALL = "ALL";
+
+  int index = static_cast<int>(level) + 1;
+  if (index < 0 || index >= static_cast<int>(sizeof(NAMES) / sizeof(NAMES[0]))) {
+    return ALL;
+  }
+  return NAMES[index];
+}
+
+static void
+notifyLogSubscriptions(const std::string& module, ndn::util::LogLevel level, const std::string& message)
+{
+  auto subscriptions = std::atomic_load(&g_logSubscriptions);
+  for (const auto& subscription : *subscriptions) {
+    subscription.callback(subscription.context, module.c_str(), getSeverityName(level).c_str(),
+                          message.c_str());
+  }
+}
+
+struct LogSinkBackend : public boost::log::sinks::basic_sink_backend<boost::log::sinks::concurrent_feeding>
+{
+  void
+  consume(const boost::log::record_view& rec)
+  {
+    auto msg = rec[boost::log::expressions::smessage].get();
+    auto module = rec[ndn::util::log::module].get();
+    auto level = rec[ndn::util::log::severity].get();
+
+    LogRing* ring = g_logRing.load();
+    if (ring != nullptr) {
+      ring->append(static_cast<int>(level), module, msg);
+    }
+
+    notifyLogSubscriptions(module, level, msg);
+  }
+};
+
+/**
+ * @brief Publish @p subscriptions; @pre g_logSubscriptionsMutex is locked
+ *
+ * Records of binary mode skip the sink, so they are formatted for the subscribers, but only while
+ * there are any.
+ */
+static void
+setLogSubscriptions(std::shared_ptr<const LogSubscriptions> subscriptions)
+{
+  blog::setTextListener(subscriptions->empty() ? nullptr : &notifyLogSubscriptions);
+  std::atomic_store(&g_logSubscriptions, std::move(subscriptions));
+}
+
+static void
+initLogging()
+{
+  static std::once_flag isInitialized;
+  std::call_once(isInitialized, [] {
+      using LogSink = boost::log::sinks::synchronous_sink<LogSinkBackend>;
+      boost::log::core::get()->add_sink(boost::make_shared<LogSink>());
+    });
+}
+
+/**
+ * @brief Owner of icear_callbacks; releases them when destroyed
+ */
+class Callbacks
+{
+public:
+  explicit
+  Callbacks(const icear_callbacks* callbacks)
+  {
+    if (callbacks != nullptr) {
+      m_callbacks = *callbacks;
+    }
+  }
+
+  Callbacks(Callbacks&& other)
+    : m_callbacks(other.m_callbacks)
+  {
+    other.m_callbacks = icear_callbacks();
+  }
+
+  Callbacks&
+  operator=(Callbacks&& other)
+  {
+    if (this != &other) {
+      release();
+      m_callbacks = other.m_callbacks;
+      other.m_callbacks = icear_callbacks();
+    }
+    return *this;
+  }
+
+  Callbacks(const Callbacks&) = delete;
+
+  Callbacks&
+  operator=(const Callbacks&) = delete;
+
+  ~Callbacks()
+  {
+    release();
+  }
+
+  void
+  onStarted() const
+  {
+    if (m_callbacks.on_started != nullptr) {
+      m_callbacks.on_started(m_callbacks.context);
+    }
+  }
+
+  void
+  onStopped() const
+  {
+    if (m_callbacks.on_stopped != nullptr) {
+      m_callbacks.on_stopped(m_callbacks.context);
+    }
+  }
+
+  /**
+   * @return identifier of the current network, empty if unknown
+   */
+  std::string
+  getNetwork() const
+  {
+    const char* network = nullptr;
+    if (m_callbacks.get_network != nullptr) {
+      network = m_callbacks.get_network(m_callbacks.context);
+    }
+    return network != nullptr ? network : "";
+  }
+
+private:
+  void
+  release()
+  {
+    if (m_callbacks.release != nullptr) {
+      m_callbacks.release(m_callbacks.context);
+    }
+    m_callbacks = icear_callbacks();
+  }
+
+private:
+  icear_callbacks m_callbacks = icear_callbacks();
+};
+
+/**
+ * @brief MobileTerminal on its own thread, with start, stop and restart from any thread
+ *
+ * The runner goes through STOPPED, RUNNING and STOPPING.  STOPPING lasts until the thread has
+ * called on_stopped, so a start arriving in the meantime is queued for that thread rather than
+ * racing with the runner being torn down.
+ */
+class Terminal
+{
+public:
+  ~Terminal();
+
+  icear_status
+  start(Params params, Callbacks callbacks);
+
+  void
+  stop();
+
+  icear_status
+  restart(Params params, Callbacks callbacks);
+
+  std::string
+  getStats();
+
+private:
+  struct Start
+  {
+    Params params;
+    Callbacks callbacks;
+  };
+
+  void
+  run(std::unique_ptr<Start> start);
+
+  /**
+   * @pre m_mutex is locked and the runner is STOPPED
+   */
+  void
+  startThread(std::unique_ptr<Start> start);
+
+  /**
+   * @pre m_mutex is locked
+   */
+  void
+  stopRunner();
+
+  /**
+   * @brief Whether the network changed since the last call; also tells the runner which network
+   *        it is on; runner thread only
+   */
+  bool
+  isSameNetwork(const Callbacks& callbacks);
+
+private:
+  enum class State {
+    STOPPED,
+    RUNNING,
+    STOPPING
+  };
+
+  std::mutex m_mutex;
+  State m_state = State::STOPPED;
+  std::unique_ptr<Start> m_pending;
+  Params m_runnerParams;
+  std::unique_ptr<ndn::ndncert::MobileTerminal> m_runner;
+  std::unique_ptr<ndn::KeyChain> m_keyChain; // kept across starts; KeyChain is not thread-safe
+  std::thread m_thread;
+
+  std::string m_network; // runner thread
+};
+
+Terminal::~Terminal()
+{
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_pending.reset();
+    stopRunner();
+  }
+  if (m_thread.joinable()) {
+    if (m_thread.get_id() == std::this_thread::get_id()) {
+      m_thread.detach(); // destroyed from a callback, against the contract; don't deadlock
+    }
+    else {
+      m_thread.join();
+    }
+  }
+}
+
+icear_status
+Terminal::start(Params params, Callbacks callbacks)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  switch (m_state) {
+  case State::RUNNING:
+    // prevent any double starts
+    NDN_LOG_TRACE("Runner already created, do nothing");
+    return ICEAR_IGNORED;
+  case State::STOPPING:
+    NDN_LOG_TRACE("Runner is stopping, will start once it is gone");
+    m_pending.reset(new Start{std::move(params), std::move(callbacks)});
+    return ICEAR_QUEUED;
+  case State::STOPPED:
+    break;
+  }
+  startThread(std::unique_ptr<Start>(new Start{std::move(params), std::move(callbacks)}));
+  return ICEAR_OK;
+}
+
+void
+Terminal::stop()
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  // an explicit stop also cancels a start queued behind an earlier stop
+  m_pending.reset();
+  stopRunner();
+}
+
+icear_status
+Terminal::restart(Params params, Callbacks callbacks)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  if (m_state == State::RUNNING && m_runner != nullptr && hasSameTransport(params, m_runnerParams)) {
+    NDN_LOG_TRACE("Restarting the running runner");
+    configure(params);
+    m_runner->restart(isHedgingEnabled(params));
+    m_runnerParams = std::move(params);
+    return ICEAR_OK;
+  }
+
+  // the transport changes (or nothing is running yet): full stop and start
+  std::unique_ptr<Start> start(new Start{std::move(params), std::move(callbacks)});
+  if (m_state == State::STOPPED) {
+    startThread(std::move(start));
+    return ICEAR_OK;
+  }
+  m_pending = std::move(start);
+  stopRunner();
+  return ICEAR_QUEUED;
+}
+
+std::string
+Terminal::getStats()
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  if (m_runner == nullptr) {
+    return "{}";
+  }
+  return formatStats(m_runner->getLoopStats(), m_runner->getLastSessionArenaStats());
+}
+
+void
+Terminal::startThread(std::unique_ptr<Start> start)
+{
+  // the previous thread has nothing left to do after it set STOPPED
+  if (m_thread.joinable()) {
+    m_thread.join();
+  }
+  m_state = State::RUNNING;
+  m_thread = std::thread(&Terminal::run, this, std::move(start));
+}
+
+void
+Terminal::stopRunner()
+{
+  if (m_state != State::RUNNING) {
+    return;
+  }
+  m_state = State::STOPPING;
+  // otherwise, the runner thread stops the runner as soon as it is created
+  if (m_runner != nullptr) {
+    m_runner->stop();
+  }
+}
+
+bool
+Terminal::isSameNetwork(const Callbacks& callbacks)
+{
+  auto network = callbacks.getNetwork();
+  // called from the runner's I/O thread, ahead of the bootstrap on the new network
+  m_runner->setNetwork(network);
+  if (network.empty()) {
+    NDN_LOG_DEBUG("Assume re-connected to a new network (unknown)");
+    return false;
+  }
+  if (network != m_network) {
+    m_network = network;
+    NDN_LOG_DEBUG("Re-connected to a new network: " << m_network);
+    return false;
+  }
+  return true;
+}
+
+void
+Terminal::run(std::unique_ptr<Start> start)
+{
+  while (true) {
+    const Callbacks& callbacks = start->callbacks;
+    try {
+      configure(start->params);
+      {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        m_network = callbacks.getNetwork();
+        NDN_LOG_INFO("Connected to network: " << (m_network.empty() ? "(unknown)" : m_network));
+
+        if (m_keyChain == nullptr) {
+          m_keyChain = std::make_unique<ndn::KeyChain>();
+        }
+
+        m_runner = std::make_unique<ndn::ndncert::MobileTerminal>(*m_keyChain, [this, &callbacks] {
+            return isSameNetwork(callbacks);
+          }, makeTransport(start->params));
+        m_runner->setHedgedIssuance(isHedgingEnabled(start->params));
+        m_runner->setStallStackCapture(getParam(start->params, "loopStallStacks") == "on");
+        m_runner->setInterface(getParam(start->params, "interface"));
+        m_runner->setNetwork(m_network);
+        m_runnerParams = start->params;
+
+        if (m_state == State::STOPPING) {
+          // stopped before the runner was created; doStart() will return right away
+          m_runner->stop();
+        }
+      }
+
+      callbacks.onStarted();
+
+      NDN_LOG_INFO("NDNCERT + AP monitoring started");
+      m_runner->doStart();
+    }
+    catch (const std::exception& e) {
+      NDN_LOG_ERROR(e.what());
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_runner.reset();
+    }
+
+    NDN_LOG_INFO("NDNCERT + AP monitoring terminated");
+    callbacks.onStopped();
+    start.reset();
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_pending == nullptr) {
+      m_state = State::STOPPED;
+      return;
+    }
+    start = std::move(m_pending);
+    m_state = State::RUNNING;
+  }
+}
+
+static Params
+toParams(const icear_param* params, size_t nParams)
+{
+  Params result;
+  for (size_t i = 0; i < nParams; ++i) {
+    if (params[i].key != nullptr && params[i].value != nullptr) {
+      result[params[i].key] = params[i].value;
+    }
+  }
+  return result;
+}
+
+} // namespace icear
+
+struct icear_terminal
+{
+  icear::Terminal impl;
+};
+
+icear_terminal*
+icear_terminal_create(void)
+{
+  icear::initLogging();
+  return new (std::nothrow) icear_terminal;
+}
+
+void
+icear_terminal_destroy(icear_terminal* terminal)
+{
+  delete terminal;
+}
+
+icear_status
+icear_terminal_start(icear_terminal* terminal, const icear_param* params, size_t n_params,
+                     const icear_callbacks* callbacks)
+{
+  icear::Callbacks ownedCallbacks(callbacks);
+  try {
+    return terminal->impl.start(icear::toParams(params, n_params), std::move(ownedCallbacks));
+  }
+  catch (const std::exception& e) {
+    NDN_LOG_ERROR(e.what());
+    return ICEAR_ERROR;
+  }
+}
+
+void
+icear_terminal_stop(icear_terminal* terminal)
+{
+  terminal->impl.stop();
+}
+
+icear_status
+icear_terminal_restart(icear_terminal* terminal, const icear_param* params, size_t n_params,
+                       const icear_callbacks* callbacks)
+{
+  icear::Callbacks ownedCallbacks(callbacks);
+  try {
+    return terminal->impl.restart(icear::toParams(params, n_params), std::move(ownedCallbacks));
+  }
+  catch (const std::exception& e) {
+    NDN_LOG_ERROR(e.what());
+    return ICEAR_ERROR;
+  }
+}
+
+size_t
+icear_terminal_get_stats(icear_terminal* terminal, char* buffer, size_t size)
+{
+  return icear::copyString(terminal->impl.getStats(), buffer, size);
+}
+
+size_t
+icear_get_metrics(uint8_t* buffer, size_t size)
+{
+  auto snapshot = icear::metrics::snapshot();
+  if (buffer != nullptr && size >= snapshot.size()) {
+    std::memcpy(buffer, snapshot.data(), snapshot.size());
+  }
+  return snapshot.size();
+}
+
+size_t
+icear_get_metric_names(const char** names, size_t size)
+{
+  auto allNames = icear::metrics::getNames();
+  for (size_t i = 0; i < std::min(size, allNames.size()); ++i) {
+    names[i] = allNames[i];
+  }
+  return allNames.size();
+}
+
+uint64_t
+icear_log_subscribe(icear_log_callback callback, void* context)
+{
+  icear::initLogging();
+
+  std::lock_guard<std::mutex> lock(icear::g_logSubscriptionsMutex);
+  auto updated = std::make_shared<icear::LogSubscriptions>(*std::atomic_load(&icear::g_logSubscriptions));
+  updated->push_back({++icear::g_lastLogSubscription, callback, context});
+  icear::setLogSubscriptions(std::move(updated));
+  return icear::g_lastLogSubscription;
+}
+
+void
+icear_log_unsubscribe(uint64_t subscription)
+{
+  std::lock_guard<std::mutex> lock(icear::g_logSubscriptionsMutex);
+  auto current = std::atomic_load(&icear::g_logSubscriptions);
+
+  auto updated = std::make_shared<icear::LogSubscriptions>();
+  for (const auto& entry : *current) {
+    if (entry.id != subscription) {
+      updated->push_back(entry);
+    }
+  }
+  if (updated->size() != current->size()) {
+    icear::setLogSubscriptions(std::move(updated));
+  }
+}
+
+size_t
+icear_format_log_record(const uint8_t* payload, size_t payload_size, char* buffer, size_t size)
+{
+  return icear::copyString(icear::blog::format(payload, payload_size), buffer, size);
+}
@@ -0,0 +1,176 @@
+/* -*- Mode:C; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#ifndef ICEAR_CORE_H
+#define ICEAR_CORE_H
+
+/**
+ * C API of icear-core, the platform-independent bootstrap client (NDN-based CA discovery and
+ * NDNCERT certificate issuance).  The same library backs the Android JNI wrapper and native
+ * daemons on Linux.
+ *
+ * All functions can be called from any thread.  Strings are UTF-8 and NUL-terminated.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define ICEAR_CORE_API __attribute__((visibility("default")))
+
+/** version of this API; incremented on incompatible changes */
+#define ICEAR_CORE_API_VERSION 1
+
+typedef enum icear_status {
+  ICEAR_OK = 0,      /**< done, or started */
+  ICEAR_QUEUED = 1,  /**< will start once the terminal being stopped is gone */
+  ICEAR_IGNORED = 2, /**< already running */
+  ICEAR_ERROR = -1
+} icear_status;
+
+/**
+ * Start parameter.  Recognized keys:
+ *   homePath         home directory; relative paths are resolved against it, and the first start in
+ *                    the process also sets HOME to it and keeps its log ring there
+ *   interface        bootstrap only on multi-access faces of this network interface (e.g., "eth1"),
+ *                    so that several terminals of a process can each serve one; default all faces
+ *   log              ndn-cxx log level configuration, e.g., "ndncert.*=ALL" (default "*=ALL");
+ *                    process-wide, set by the latest start
+ *   logMode          "binary" to store log records in the ring in binary form; process-wide
+ *   faceCapture      record forwarder traffic into the given file
+ *   faceReplay       play forwarder traffic back from the given file instead of connecting to NFD
+ *   faceReplaySpeed  "full" to replay as fast as possible
+ *   ndncertHedging   "on" to race a second CA when the first one is slow
+ *   loopStallStacks  "on" to log the I/O thread's stack on loop stalls (installs a SIGURG handler)
+ */
+typedef struct icear_param {
+  const char* key;
+  const char* value;
+} icear_param;
+
+/**
+ * Callbacks of one start of a terminal; all are called on the terminal's thread.
+ *
+ * The terminal takes the callbacks over in icear_terminal_start and icear_terminal_restart (even
+ * if it does not start), and calls release exactly once when it no longer needs them.
+ */
+typedef struct icear_callbacks {
+  void* context;
+
+  /** the terminal has started; may be NULL */
+  void (*on_started)(void* context);
+
+  /** the terminal has stopped; may be NULL */
+  void (*on_stopped)(void* context);
+
+  /**
+   * Identifier of the current network (e.g., BSSID of the access point), or NULL or "" if
+   * unknown.  A network change triggers a new bootstrap only if the identifier changed, and the
+   * CA found on a network is remembered under its identifier for the next visit.  The
+   * returned string must stay valid until the next call.  May be NULL to bootstrap on every
+   * network change.
+   */
+  const char* (*get_network)(void* context);
+
+  /** the callbacks will not be called anymore; may be NULL */
+  void (*release)(void* context);
+} icear_callbacks;
+
+typedef struct icear_terminal icear_terminal;
+
+/**
+ * Create a stopped terminal.  Each terminal runs on its own thread while started.
+ */
+ICEAR_CORE_API icear_terminal*
+icear_terminal_create(void);
+
+/**
+ * Stop the terminal, wait until it is gone and free it.  Must not be called from its callbacks.
+ */
+ICEAR_CORE_API void
+icear_terminal_destroy(icear_terminal* terminal);
+
+/**
+ * Start the terminal with the given parameters.
+ * @return ICEAR_OK if started, ICEAR_QUEUED if it will start once the previous run is stopped,
+ *         ICEAR_IGNORED if it is already running, ICEAR_ERROR if the callbacks are unusable
+ */
+ICEAR_CORE_API icear_status
+icear_terminal_start(icear_terminal* terminal, const icear_param* params, size_t n_params,
+                     const icear_callbacks* callbacks);
+
+/**
+ * Stop the terminal; returns immediately.  on_stopped is called once the terminal is gone,
+ * within about a second.  Also cancels a start queued with ICEAR_QUEUED.
+ */
+ICEAR_CORE_API void
+icear_terminal_stop(icear_terminal* terminal);
+
+/**
+ * Restart with new parameters.  If the terminal runs with the same forwarder transport (homePath,
+ * faceCapture, faceReplay and faceReplaySpeed) and interface, only the bootstrap is run again,
+ * keeping the keys, routes and CA state, and callbacks are released unused.
+ * Otherwise, the terminal is stopped and started anew with callbacks.
+ */
+ICEAR_CORE_API icear_status
+icear_terminal_restart(icear_terminal* terminal, const icear_param* params, size_t n_params,
+                       const icear_callbacks* callbacks);
+
+/**
+ * Statistics of the running terminal as a JSON object ("{}" if not running): I/O loop lag and
+ * stalls, and arena allocations of the last finished bootstrap session.  Like snprintf,
+ * writes at most size octets including the terminating NUL.
+ * @return length of the full JSON text, without the terminating NUL
+ */
+ICEAR_CORE_API size_t
+icear_terminal_get_stats(icear_terminal* terminal, char* buffer, size_t size);
+
+/**
+ * Snapshot of process metrics in the binary layout described in metrics.hpp; writes nothing if
+ * size is too small.
+ * @return size of the snapshot
+ */
+ICEAR_CORE_API size_t
+icear_get_metrics(uint8_t* buffer, size_t size);
+
+/**
+ * Names of the metrics, in snapshot order; the strings are static.
+ * @return number of metrics (at most size of them are stored)
+ */
+ICEAR_CORE_API size_t
+icear_get_metric_names(const char** names, size_t size);
+
+/**
+ * Receiver of log records; called on the logging thread, possibly concurrently.
+ */
+typedef void (*icear_log_callback)(void* context, const char* module, const char* severity,
+                                   const char* message);
+
+/**
+ * Subscribe to log records of all terminals.  In binary log mode, records are formatted for
+ * subscribers while there are any, so subscribe only while the records are needed.
+ * @return subscription ID, to be passed to icear_log_unsubscribe
+ */
+ICEAR_CORE_API uint64_t
+icear_log_subscribe(icear_log_callback callback, void* context);
+
+/**
+ * Unsubscribe; the callback may still be running on other threads when this returns.
+ */
+ICEAR_CORE_API void
+icear_log_unsubscribe(uint64_t subscription);
+
+/**
+ * Format a binary log record payload (log ring record of BINARY type) as text, like snprintf.
+ * @return length of the full text, without the terminating NUL
+ */
+ICEAR_CORE_API size_t
+icear_format_log_record(const uint8_t* payload, size_t payload_size, char* buffer, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ICEAR_CORE_H */
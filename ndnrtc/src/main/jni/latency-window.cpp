@@ -0,0 +1,45 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#include "latency-window.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#include <boost/assert.hpp>
+
+namespace ndn {
+namespace ndncert {
+
+LatencyWindow::LatencyWindow(size_t capacity)
+  : m_capacity(std::max<size_t>(capacity, 1))
+{
+  m_samples.reserve(m_capacity);
+}
+
+void
+LatencyWindow::addSample(time::nanoseconds latency)
+{
+  if (m_samples.size() < m_capacity) {
+    m_samples.push_back(latency);
+  }
+  else {
+    m_samples[m_next] = latency;
+  }
+  m_next = (m_next + 1) % m_capacity;
+}
+
+time::nanoseconds
+LatencyWindow::getPercentile(double percentile) const
+{
+  BOOST_ASSERT(!m_samples.empty());
+
+  // nearest-rank percentile over a copy; the window is small
+  std::vector<time::nanoseconds> sorted(m_samples);
+  size_t rank = static_cast<size_t>(std::ceil(std::min(std::max(percentile, 0.0), 1.0) * sorted.size()));
+  size_t index = rank > 0 ? rank - 1 : 0;
+  std::nth_element(sorted.begin(), sorted.begin() + index, sorted.end());
+  return sorted[index];
+}
+
+} // namespace ndncert
+} // namespace ndn
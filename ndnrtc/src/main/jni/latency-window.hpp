@@ -0,0 +1,47 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#ifndef ICEAR_LATENCY_WINDOW_HPP
+#define ICEAR_LATENCY_WINDOW_HPP
+
+#include <ndn-cxx/util/time.hpp>
+
+#include <vector>
+
+namespace ndn {
+namespace ndncert {
+
+/**
+ * @brief Sliding window of the latest latency samples, for percentile-based deadlines
+ */
+class LatencyWindow
+{
+public:
+  explicit
+  LatencyWindow(size_t capacity = 32);
+
+  void
+  addSample(time::nanoseconds latency);
+
+  size_t
+  size() const
+  {
+    return m_samples.size();
+  }
+
+  /**
+   * @brief Latency not exceeded by @p percentile (0..1) of the samples in the window
+   * @pre size() > 0
+   */
+  time::nanoseconds
+  getPercentile(double percentile) const;
+
+private:
+  const size_t m_capacity;
+  std::vector<time::nanoseconds> m_samples; // ring buffer
+  size_t m_next = 0;
+};
+
+} // namespace ndncert
+} // namespace ndn
+
+#endif // ICEAR_LATENCY_WINDOW_HPP
@@ -0,0 +1,153 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#include "location-challenge-tlv.hpp"
+
+#include <ndn-cxx/encoding/block-helpers.hpp>
+#include <ndn-cxx/encoding/tlv.hpp>
+#include <ndn-cxx/util/exception.hpp>
+
+namespace ndn {
+namespace ndncert {
+
+static Block
+makeBytesBlock(uint32_t type, const std::string& value)
+{
+  return makeBinaryBlock(type, reinterpret_cast<const uint8_t*>(value.data()), value.size());
+}
+
+static std::string
+readBytes(const Block& block)
+{
+  return std::string(reinterpret_cast<const char*>(block.value()), block.value_size());
+}
+
+static size_t
+sizeOfElement(uint32_t type, const std::string& value)
+{
+  return tlv::sizeOfVarNumber(type) + tlv::sizeOfVarNumber(value.size()) + value.size();
+}
+
+static void
+writeElement(std::ostream& os, uint32_t type, const std::string& value)
+{
+  tlv::writeVarNumber(os, type);
+  tlv::writeVarNumber(os, value.size());
+  os.write(value.data(), value.size());
+}
+
+Block
+LocalhopValidateRequest::wireEncode() const
+{
+  Block wire(location_tlv::LocalhopValidateRequest);
+  wire.push_back(makeStringBlock(location_tlv::RequestId, requestId));
+  wire.push_back(makeStringBlock(location_tlv::ChallengeType, challengeType));
+  wire.push_back(makeStringBlock(location_tlv::Status, status));
+  wire.push_back(makeBytesBlock(location_tlv::Code, code));
+  wire.encode();
+  return wire;
+}
+
+void
+LocalhopValidateRequest::wireEncode(std::ostream& os) const
+{
+  size_t length = sizeOfElement(location_tlv::RequestId, requestId) +
+                  sizeOfElement(location_tlv::ChallengeType, challengeType) +
+                  sizeOfElement(location_tlv::Status, status) +
+                  sizeOfElement(location_tlv::Code, code);
+  tlv::writeVarNumber(os, location_tlv::LocalhopValidateRequest);
+  tlv::writeVarNumber(os, length);
+  writeElement(os, location_tlv::RequestId, requestId);
+  writeElement(os, location_tlv::ChallengeType, challengeType);
+  writeElement(os, location_tlv::Status, status);
+  writeElement(os, location_tlv::Code, code);
+}
+
+void
+LocalhopValidateRequest::wireDecode(const Block& wire)
+{
+  if (wire.type() != location_tlv::LocalhopValidateRequest) {
+    NDN_THROW(tlv::Error("Unexpected TLV-TYPE " + to_string(wire.type()) + " of LocalhopValidateRequest"));
+  }
+  wire.parse();
+
+  *this = LocalhopValidateRequest();
+  for (const auto& element : wire.elements()) {
+    switch (element.type()) {
+    case location_tlv::RequestId:
+      requestId = readString(element);
+      break;
+    case location_tlv::ChallengeType:
+      challengeType = readString(element);
+      break;
+    case location_tlv::Status:
+      status = readString(element);
+      break;
+    case location_tlv::Code:
+      code = readBytes(element);
+      break;
+    default:
+      // unknown elements are ignored to allow extending the format
+      break;
+    }
+  }
+}
+
+const std::string LocalhopValidateResponse::JSON_TLV_SUPPORTED = "localhop-tlv";
+
+bool
+LocalhopValidateResponse::isTlvResponse(const Data& data)
+{
+  const Block& content = data.getContent();
+  // JSON content always starts with '{', which can't be confused with the TLV-TYPE
+  return content.value_size() > 0 && content.value()[0] == location_tlv::LocalhopValidateResponse;
+}
+
+Block
+LocalhopValidateResponse::wireEncode() const
+{
+  Block wire(location_tlv::LocalhopValidateResponse);
+  wire.push_back(makeStringBlock(location_tlv::Status, status));
+  if (!code.empty()) {
+    wire.push_back(makeBytesBlock(location_tlv::Code, code));
+  }
+  if (!errorInfo.empty()) {
+    wire.push_back(makeStringBlock(location_tlv::ErrorInfo, errorInfo));
+  }
+  wire.encode();
+  return wire;
+}
+
+void
+LocalhopValidateResponse::wireDecode(const Block& wire)
+{
+  if (wire.type() != location_tlv::LocalhopValidateResponse) {
+    NDN_THROW(tlv::Error("Unexpected TLV-TYPE " + to_string(wire.type()) + " of LocalhopValidateResponse"));
+  }
+  wire.parse();
+
+  *this = LocalhopValidateResponse();
+  bool hasStatus = false;
+  for (const auto& element : wire.elements()) {
+    switch (element.type()) {
+    case location_tlv::Status:
+      status = readString(element);
+      hasStatus = true;
+      break;
+    case location_tlv::Code:
+      code = readBytes(element);
+      break;
+    case location_tlv::ErrorInfo:
+      errorInfo = readString(element);
+      break;
+    default:
+      break;
+    }
+  }
+
+  if (!hasStatus) {
+    NDN_THROW(tlv::Error("Missing Status element in LocalhopValidateResponse"));
+  }
+}
+
+} // namespace ndncert
+} // namespace ndn
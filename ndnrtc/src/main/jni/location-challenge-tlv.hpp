@@ -0,0 +1,105 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#ifndef ICEAR_LOCATION_CHALLENGE_TLV_HPP
+#define ICEAR_LOCATION_CHALLENGE_TLV_HPP
+
+#include <ndn-cxx/encoding/block.hpp>
+#include <ndn-cxx/data.hpp>
+
+#include <ostream>
+#include <string>
+
+namespace ndn {
+namespace ndncert {
+
+/**
+ * @brief Compact TLV encoding of the LOCATION challenge localhop validation exchange
+ *
+ * Request (single name component after LOCALHOP_VALIDATION_PREFIX):
+ *
+ *     LocalhopValidateRequest = LOCALHOP-VALIDATE-REQUEST-TYPE TLV-LENGTH
+ *                                 RequestId
+ *                                 ChallengeType
+ *                                 Status
+ *                                 Code           ; code1, clear text
+ *
+ * Response (Data content):
+ *
+ *     LocalhopValidateResponse = LOCALHOP-VALIDATE-RESPONSE-TYPE TLV-LENGTH
+ *                                  Status
+ *                                  [Code]        ; code2, encrypted to the requester's key (no base64)
+ *                                  [ErrorInfo]
+ *
+ * The client asks in the JSON-in-Name format until the CA advertises TLV support by including
+ * `"localhop-tlv": "true"` in a JSON response.  A CA that stops understanding the request later
+ * either does not answer it, or answers in JSON, in which case the client falls back to JSON.
+ */
+namespace location_tlv {
+
+enum : uint32_t {
+  LocalhopValidateRequest = 192,
+  LocalhopValidateResponse = 193,
+  RequestId = 194,
+  ChallengeType = 195,
+  Status = 196,
+  Code = 197,
+  ErrorInfo = 198
+};
+
+} // namespace location_tlv
+
+enum class LocalhopEncoding {
+  TLV,
+  JSON
+};
+
+class LocalhopValidateRequest
+{
+public:
+  Block
+  wireEncode() const;
+
+  /**
+   * @brief Write the same encoding as wireEncode() to @p os, without building Blocks
+   */
+  void
+  wireEncode(std::ostream& os) const;
+
+  void
+  wireDecode(const Block& wire);
+
+public:
+  std::string requestId;
+  std::string challengeType;
+  std::string status;
+  std::string code;
+};
+
+class LocalhopValidateResponse
+{
+public:
+  /// field of a JSON response by which the CA advertises that it accepts TLV requests
+  static const std::string JSON_TLV_SUPPORTED;
+
+  /**
+   * @brief Check whether @p data carries a TLV (rather than JSON) response
+   */
+  static bool
+  isTlvResponse(const Data& data);
+
+  Block
+  wireEncode() const;
+
+  void
+  wireDecode(const Block& wire);
+
+public:
+  std::string status;
+  std::string code; ///< raw (binary) encrypted code2, empty if absent
+  std::string errorInfo;
+};
+
+} // namespace ndncert
+} // namespace ndn
+
+#endif // ICEAR_LOCATION_CHALLENGE_TLV_HPP
@@ -1,15 +1,18 @@
 /* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
 
 #include "location-client-tool.hpp"
+#include "binary-log.hpp"
+#include "metrics.hpp"
 
 #include <ndncert/challenge-module/location-challenge.hpp>
 #include <ndncert/logging.hpp>
 
 #include <unistd.h>
 #include <iostream>
+#include <sstream>
 #include <string>
 
-#include <ndn-cxx/encoding/buffer-stream.hpp>
+#include <ndn-cxx/lp/tags.hpp>
 #include <ndn-cxx/security/signing-helpers.hpp>
 #include <ndn-cxx/security/transform.hpp>
 #include <ndn-cxx/security/verification-helpers.hpp>
@@ -22,10 +25,16 @@ namespace ndncert {
 
 _LOG_INIT(ndncert.LocationClientTool);
 
-LocationClientTool::LocationClientTool(Face& face, KeyChain& keyChain, const Name& caPrefix, const Certificate& caCert)
+static const size_t LOCALHOP_VALIDATE_RETRIES = 3;
+
+LocationClientTool::LocationClientTool(Face& face, KeyChain& keyChain, const Name& caPrefix, const Certificate& caCert,
+                                       CaContext& ca, CaVerifierCache& verifiers, SessionArena& arena)
   : client(face, keyChain)
   , m_keyChain(keyChain)
   , m_face(face)
+  , m_ca(ca)
+  , m_verifiers(verifiers)
+  , m_arena(arena)
 {
   namespace t = ndn::security::transform;
   std::ostringstream os;
@@ -65,177 +74,425 @@ LocationClientTool::LocationClientTool(Face& face, KeyChain& keyChain, const Nam
 void
 LocationClientTool::start(const std::string& userIdentity)
 {
+  cancel();
+
   ClientCaItem targetCaItem(*(client.getClientConf().m_caItems.begin()));
 
   // Start with _PROBE
-  client.sendProbe(targetCaItem, userIdentity,
-                   bind(&LocationClientTool::newCb, this, _1),
-                   bind(&LocationClientTool::errorCb, this, _1));
+  startStep(Step::PROBE);
+  client.sendProbe(targetCaItem, userIdentity, makeRequestCallback(), makeErrorCallback());
+}
+
+void
+LocationClientTool::cancel()
+{
+  ++m_requestId;
+  m_step = Step::IDLE;
+  m_state.reset();
+  m_encryptedCode2.clear();
+  m_localhopPendingInterest.cancel();
+}
+
+ClientModule::RequestCallback
+LocationClientTool::makeRequestCallback()
+{
+  // keep captures to `this` + ID, so nothing from the request state gets copied into closures
+  uint64_t requestId = m_requestId;
+  return [this, requestId] (const shared_ptr<RequestState>& state) {
+    if (requestId != m_requestId) {
+      return; // cancelled or restarted
+    }
+    onStepSucceeded(state);
+  };
+}
+
+ClientModule::ErrorCallback
+LocationClientTool::makeErrorCallback()
+{
+  uint64_t requestId = m_requestId;
+  return [this, requestId] (const std::string& errorInfo) {
+    if (requestId != m_requestId) {
+      return; // cancelled or restarted
+    }
+    errorCb(errorInfo);
+  };
+}
+
+void
+LocationClientTool::onStepSucceeded(const shared_ptr<RequestState>& state)
+{
+  m_state = state;
+
+  switch (m_step) {
+  case Step::PROBE:
+    finishStep();
+    newCb();
+    break;
+  case Step::SELECT:
+    finishStep();
+    selectCb();
+    break;
+  case Step::LOCALHOP_VALIDATE:
+    // RTT is sampled per transmission in expressLocalhopValidate
+    localhopValidateCb();
+    break;
+  case Step::VALIDATE:
+    finishStep();
+    validateCb();
+    break;
+  case Step::DOWNLOAD:
+    finishStep();
+    downloadCb();
+    break;
+  case Step::IDLE:
+  case Step::DONE:
+    break;
+  }
 }
 
 void
 LocationClientTool::errorCb(const std::string& errorInfo)
 {
-  NDN_LOG_ERROR("ERROR: " << errorInfo);
+  ICEAR_BLOG_ERROR(GENERIC_ERROR, errorInfo);
+  icear::metrics::add(icear::metrics::Counter::NDNCERT_STEP_FAILURES);
+  cancel();
   onFailure(errorInfo);
 }
 
 void
-LocationClientTool::newCb(const shared_ptr<RequestState>& state)
+LocationClientTool::startStep(Step step)
 {
-  state->challenge = ChallengeModule::createChallengeModule(LOCATION_CHALLENGE);
-  BOOST_ASSERT(state->challenge != nullptr);
+  m_step = step;
+  m_stepStart = time::steady_clock::now();
+  onStepStarted(step);
+}
 
-  client.sendSelect(state, LOCATION_CHALLENGE, state->challenge->genSelectParamsJson(state->m_status, {}),
-                    [this] (const shared_ptr<RequestState>& state) {
-                      selectCb(state);
-                    },
-                    bind(&LocationClientTool::errorCb, this, _1));
+void
+LocationClientTool::finishStep()
+{
+  // not an RTT sample: ClientModule retransmits internally, and a step answered after a
+  // retransmission cannot be told apart (Karn's algorithm), so the estimator is fed only by the
+  // localhop validation exchanges the tool sends itself
+  auto duration = time::steady_clock::now() - m_stepStart;
+  icear::metrics::record(icear::metrics::Histogram::NDNCERT_STEP_LATENCY, duration);
 }
 
-static std::string
-base64DecodeAndDecrypt(const std::string& encrypted, KeyChain& keyChain, const Name& keyName)
+void
+LocationClientTool::newCb()
 {
-  namespace t = ndn::security::transform;
+  m_state->challenge = ChallengeModule::createChallengeModule(LOCATION_CHALLENGE);
+  BOOST_ASSERT(m_state->challenge != nullptr);
 
-  // decode base64
-  std::istringstream is(encrypted);
-  OBufferStream os;
-  t::streamSource(is) >> t::stripSpace("\n") >> t::base64Decode(false) >> t::streamSink(os);
-  // decrypt
-  auto codeBuffer = keyChain.getTpm().decrypt(os.buf()->data(), os.buf()->size(), keyName);
+  startStep(Step::SELECT);
+  client.sendSelect(m_state, LOCATION_CHALLENGE, m_state->challenge->genSelectParamsJson(m_state->m_status, {}),
+                    makeRequestCallback(), makeErrorCallback());
+}
+
+ArenaString
+decryptCode(const uint8_t* encrypted, size_t size, KeyChain& keyChain, const Name& keyName,
+            SessionArena& arena)
+{
+  auto codeBuffer = keyChain.getTpm().decrypt(encrypted, size, keyName);
 
   // convert to unencrypted code string and store in the client state
-  return std::string(reinterpret_cast<const char*>(codeBuffer->data()), codeBuffer->size());
+  return ArenaString(reinterpret_cast<const char*>(codeBuffer->data()), codeBuffer->size(),
+                     ArenaAllocator<char>(arena));
+}
+
+ArenaString
+base64DecodeAndDecryptCode(const std::string& encrypted, KeyChain& keyChain, const Name& keyName,
+                           SessionArena& arena)
+{
+  namespace t = ndn::security::transform;
+
+  // decode base64 (straight from the string, without an intermediate stream copy)
+  ArenaStreamBuf decoded(arena, encrypted.size());
+  std::ostream os(&decoded);
+  t::bufferSource(encrypted) >> t::stripSpace("\n") >> t::base64Decode(false) >> t::streamSink(os);
+
+  return decryptCode(decoded.data(), decoded.size(), keyChain, keyName, arena);
+}
+
+/**
+ * @brief Same name component as ClientModule::nameBlockFromJson, serialized in @p arena
+ */
+static name::Component
+makeJsonComponent(const JsonSection& json, SessionArena& arena)
+{
+  ArenaStreamBuf buffer(arena);
+  std::ostream os(&buffer);
+  boost::property_tree::write_json(os, json);
+  return name::Component(buffer.data(), buffer.size());
 }
 
 void
-LocationClientTool::selectCb(const shared_ptr<RequestState>& state)
+LocationClientTool::selectCb()
 {
   // decode what needs to be decoded
-  auto code1 = state->challengeData.find("code1");
-  if (code1 == state->challengeData.end()) {
-    std::cerr << "ERROR: the _SELECT/LOCATION response didn't include expected `code1` field" << std::endl;
+  auto code1 = m_state->challengeData.find("code1");
+  if (code1 == m_state->challengeData.end()) {
+    errorCb("the _SELECT/LOCATION response didn't include expected `code1` field");
     return;
   }
 
-  code1->second = base64DecodeAndDecrypt(code1->second, m_keyChain, state->m_key.getName());
+  // the decrypted code is shorter than its base64 text, so it fits into the same string
+  auto code = base64DecodeAndDecryptCode(code1->second, m_keyChain, m_state->m_key.getName(), m_arena);
+  code1->second.assign(code.data(), code.size());
 
   // !! the code will be sent in clear text !! (at least for now)
-  sendLocalhopValidate(state, static_cast<LocationChallenge*>(state->challenge.get())->genLocalhopParamsJson(state->m_status, {code1->second}),
-                      [this] (const shared_ptr<RequestState>& state) {
-                        localhopValidateCb(state);
-                      },
-                      bind(&LocationClientTool::errorCb, this, _1));
+  m_localhopCode = code1->second;
+  m_localhopParams = static_cast<LocationChallenge*>(m_state->challenge.get())->genLocalhopParamsJson(m_state->m_status, {code1->second});
+  sendLocalhopValidate();
 }
 
 void
-LocationClientTool::sendLocalhopValidate(const shared_ptr<RequestState>& state,
-                                         const JsonSection& validateParams,
-                                         const ClientModule::RequestCallback& requestCallback,
-                                         const ClientModule::ErrorCallback& errorCallback)
+LocationClientTool::sendLocalhopValidate()
 {
-  JsonSection requestIdJson;
-  requestIdJson.put(JSON_REQUEST_ID, state->m_requestId);
-  std::string challType = state->m_challengeType;
+  startStep(Step::LOCALHOP_VALIDATE);
+  m_localhopInterest = makeLocalhopValidateInterest(m_ca.localhopEncoding);
+  expressLocalhopValidate(LOCALHOP_VALIDATE_RETRIES);
+}
 
+Interest
+LocationClientTool::makeLocalhopValidateInterest(LocalhopEncoding encoding)
+{
   Name interestName(LocationChallenge::LOCALHOP_VALIDATION_PREFIX);
-  interestName
-    .append(ClientModule::nameBlockFromJson(requestIdJson))
-    .append(state->m_challengeType)
-    .append(ClientModule::nameBlockFromJson(validateParams));
+
+  if (encoding == LocalhopEncoding::TLV) {
+    LocalhopValidateRequest request;
+    request.requestId = m_state->m_requestId;
+    request.challengeType = m_state->m_challengeType;
+    request.status = m_state->m_status;
+    request.code = m_localhopCode;
+
+    ArenaStreamBuf wire(m_arena);
+    std::ostream os(&wire);
+    request.wireEncode(os);
+    interestName.append(Block(wire.data(), wire.size()));
+  }
+  else {
+    JsonSection requestIdJson;
+    requestIdJson.put(JSON_REQUEST_ID, m_state->m_requestId);
+
+    interestName
+      .append(makeJsonComponent(requestIdJson, m_arena))
+      .append(m_state->m_challengeType)
+      .append(makeJsonComponent(m_localhopParams, m_arena));
+  }
+
   Interest interest(interestName);
   interest.setCanBePrefix(false);
-  m_keyChain.sign(interest, signingByKey(state->m_key.getName()));
+  m_keyChain.sign(interest, signingByKey(m_state->m_key.getName()));
+  if (m_localhopFaceId != 0) {
+    interest.setTag(make_shared<lp::NextHopFaceIdTag>(m_localhopFaceId));
+  }
+  return interest;
+}
 
-  DataCallback dataCb = bind(&LocationClientTool::handleLocalhopValidateResponse,
-                             this, _1, _2, state, requestCallback, errorCallback);
-  m_face.expressInterest(interest, dataCb,
-                         bind(&ClientModule::onNack, &client, _1, _2, errorCallback),
-                         bind(&ClientModule::onTimeout, &client, _1, 3,
-                              dataCb, errorCallback));
+bool
+LocationClientTool::fallbackToJsonEncoding()
+{
+  if (m_ca.localhopEncoding != LocalhopEncoding::TLV || m_ca.isLocalhopEncodingConfirmed) {
+    return false;
+  }
 
-  _LOG_TRACE(LocationChallenge::LOCALHOP_VALIDATION_PREFIX << " interest sent");
+  ICEAR_BLOG_DEBUG(LOCALHOP_JSON_FALLBACK, Name(LocationChallenge::LOCALHOP_VALIDATION_PREFIX));
+  m_ca.localhopEncoding = LocalhopEncoding::JSON;
+  m_localhopInterest = makeLocalhopValidateInterest(LocalhopEncoding::JSON);
+  return true;
 }
 
 void
-LocationClientTool::handleLocalhopValidateResponse(const Interest& request,
-                                                   const Data& reply,
-                                                   const shared_ptr<RequestState>& state,
-                                                   const ClientModule::RequestCallback& requestCallback,
-                                                   const ClientModule::ErrorCallback& errorCallback)
+LocationClientTool::expressLocalhopValidate(size_t nRetriesLeft)
 {
-  if (!security::verifySignature(reply, state->m_ca.m_anchor)) {
-    errorCallback("Cannot verify data from " + state->m_ca.m_caName.toUri());
+  // lifetime doubles as the retransmission timer
+  m_localhopInterest.setInterestLifetime(m_ca.rtt.getInterestLifetime());
+  m_localhopInterest.refreshNonce();
+
+  // Karn's algorithm: a Data after a timeout may answer any of the previous transmissions
+  bool isRetransmission = nRetriesLeft < LOCALHOP_VALIDATE_RETRIES;
+  auto sentTime = time::steady_clock::now();
+  uint64_t requestId = m_requestId;
+
+  m_localhopPendingInterest = m_face.expressInterest(m_localhopInterest,
+    [this, requestId, isRetransmission, sentTime] (const Interest&, const Data& reply) {
+      if (requestId != m_requestId) {
+        return;
+      }
+      if (!isRetransmission) {
+        m_ca.rtt.addMeasurement(time::steady_clock::now() - sentTime);
+      }
+      handleLocalhopValidateResponse(reply);
+    },
+    [this, requestId, nRetriesLeft] (const Interest&, const lp::Nack& nack) {
+      if (requestId != m_requestId) {
+        return;
+      }
+      if (fallbackToJsonEncoding()) {
+        expressLocalhopValidate(nRetriesLeft);
+        return;
+      }
+      std::ostringstream os;
+      os << "Got NACK (" << nack.getReason() << ") for " << LocationChallenge::LOCALHOP_VALIDATION_PREFIX;
+      errorCb(os.str());
+    },
+    [this, requestId, nRetriesLeft] (const Interest&) {
+      if (requestId != m_requestId) {
+        return;
+      }
+      if (nRetriesLeft == 0) {
+        errorCb("Timed out waiting for " + Name(LocationChallenge::LOCALHOP_VALIDATION_PREFIX).toUri() + " response");
+        return;
+      }
+      m_ca.rtt.backoffRto();
+      // the loss may as well be a CA that ignores TLV requests; the retransmission asks in JSON
+      fallbackToJsonEncoding();
+      ICEAR_BLOG_TRACE(LOCALHOP_TIMEOUT, Name(LocationChallenge::LOCALHOP_VALIDATION_PREFIX),
+                       m_ca.rtt.getInterestLifetime());
+      expressLocalhopValidate(nRetriesLeft - 1);
+    });
+
+  ICEAR_BLOG_TRACE(LOCALHOP_SENT, Name(LocationChallenge::LOCALHOP_VALIDATION_PREFIX));
+}
+
+void
+LocationClientTool::handleLocalhopValidateResponse(const Data& reply)
+{
+  if (!m_verifiers.verify(reply, m_state->m_ca.m_anchor)) {
+    errorCb("Cannot verify data from " + m_state->m_ca.m_caName.toUri());
     return;
   }
+
+  try {
+    if (LocalhopValidateResponse::isTlvResponse(reply)) {
+      m_ca.localhopEncoding = LocalhopEncoding::TLV;
+      m_ca.isLocalhopEncodingConfirmed = true;
+      handleLocalhopValidateTlvResponse(reply);
+    }
+    else if (m_ca.localhopEncoding == LocalhopEncoding::TLV) {
+      // the CA no longer understands TLV and most likely answered with an error status; that
+      // says nothing about the challenge, so ask again in JSON right away
+      ICEAR_BLOG_DEBUG(LOCALHOP_JSON_REPLY, Name(LocationChallenge::LOCALHOP_VALIDATION_PREFIX));
+      m_ca.localhopEncoding = LocalhopEncoding::JSON;
+      m_ca.isLocalhopEncodingConfirmed = true;
+      m_localhopInterest = makeLocalhopValidateInterest(LocalhopEncoding::JSON);
+      expressLocalhopValidate(LOCALHOP_VALIDATE_RETRIES);
+    }
+    else {
+      m_ca.localhopEncoding = LocalhopEncoding::JSON;
+      m_ca.isLocalhopEncodingConfirmed = true;
+      handleLocalhopValidateJsonResponse(reply);
+    }
+  }
+  catch (const std::exception& e) {
+    errorCb("Malformed " + Name(LocationChallenge::LOCALHOP_VALIDATION_PREFIX).toUri() + " response: " + e.what());
+  }
+}
+
+void
+LocationClientTool::handleLocalhopValidateJsonResponse(const Data& reply)
+{
   //gotMessage = reply.getName()[-1].toUri();
   JsonSection json = ClientModule::getJsonFromData(reply);
-  state->m_status = json.get<std::string>(JSON_STATUS);
+  m_state->m_status = json.get<std::string>(JSON_STATUS);
 
   auto challengeData = json.get_child_optional(JSON_CHALLENGE_DATA);
   if (challengeData) {
     for (const auto& item : *challengeData) {
       // this may throw if there are unexpected items inside returned challenge-data
-      state->challengeData[item.first] = item.second.get_value<std::string>();
+      m_state->challengeData[item.first] = item.second.get_value<std::string>();
     }
   }
 
-  if (!ClientModule::checkStatus(*state, json, errorCallback)) {
+  if (!ClientModule::checkStatus(*m_state, json, makeErrorCallback())) {
     return;
   }
 
-  _LOG_TRACE("Got " << LocationChallenge::LOCALHOP_VALIDATION_PREFIX << " response with status " << state->m_status);
+  if (json.get(LocalhopValidateResponse::JSON_TLV_SUPPORTED, "") == "true") {
+    // next exchanges ask in TLV; unconfirmed, so that a lost TLV request still falls back to JSON
+    m_ca.localhopEncoding = LocalhopEncoding::TLV;
+    m_ca.isLocalhopEncodingConfirmed = false;
+  }
+
+  ICEAR_BLOG_TRACE(LOCALHOP_RESPONSE, Name(LocationChallenge::LOCALHOP_VALIDATION_PREFIX), m_state->m_status);
 
-  requestCallback(state);
+  onStepSucceeded(m_state);
 }
 
 void
-LocationClientTool::localhopValidateCb(const shared_ptr<RequestState>& state)
+LocationClientTool::handleLocalhopValidateTlvResponse(const Data& reply)
 {
-  // decode what needs to be decoded
-  auto code2 = state->challengeData.find("code2");
-  if (code2 == state->challengeData.end()) {
-    NDN_LOG_ERROR("ERROR: the _SELECT/LOCATION response didn't include expected `code2` field");
+  LocalhopValidateResponse response;
+  response.wireDecode(reply.getContent().blockFromValue());
+
+  m_state->m_status = response.status;
+  if (m_state->m_status == ChallengeModule::FAILURE) {
+    errorCb("Error from " + m_state->m_ca.m_caName.toUri() + ": " + response.errorInfo);
     return;
   }
+  m_encryptedCode2 = std::move(response.code);
+
+  ICEAR_BLOG_TRACE(LOCALHOP_TLV_RESPONSE, Name(LocationChallenge::LOCALHOP_VALIDATION_PREFIX), m_state->m_status);
 
-  code2->second = base64DecodeAndDecrypt(code2->second, m_keyChain, state->m_key.getName());
+  onStepSucceeded(m_state);
+}
+
+void
+LocationClientTool::localhopValidateCb()
+{
+  // decode what needs to be decoded
+  ArenaString decrypted{ArenaAllocator<char>(m_arena)};
+  if (!m_encryptedCode2.empty()) {
+    // TLV response carries the encrypted code as is
+    decrypted = decryptCode(reinterpret_cast<const uint8_t*>(m_encryptedCode2.data()), m_encryptedCode2.size(),
+                            m_keyChain, m_state->m_key.getName(), m_arena);
+    m_encryptedCode2.clear();
+  }
+  else {
+    auto encoded = m_state->challengeData.find("code2");
+    if (encoded == m_state->challengeData.end()) {
+      errorCb("the _SELECT/LOCATION response didn't include expected `code2` field");
+      return;
+    }
+    decrypted = base64DecodeAndDecryptCode(encoded->second, m_keyChain, m_state->m_key.getName(), m_arena);
+  }
+  // replaces the base64 text (if any), which is longer
+  std::string& code2 = m_state->challengeData["code2"];
+  code2.assign(decrypted.data(), decrypted.size());
 
   // !! the code will be sent in clear text !! (at least for now)
-  client.sendValidate(state, state->challenge->genValidateParamsJson(state->m_status, {code2->second}),
-                      [this] (const shared_ptr<RequestState>& state) {
-                        validateCb(state);
-                      },
-                      bind(&LocationClientTool::errorCb, this, _1));
+  startStep(Step::VALIDATE);
+  client.sendValidate(m_state, m_state->challenge->genValidateParamsJson(m_state->m_status, {code2}),
+                      makeRequestCallback(), makeErrorCallback());
 }
 
 void
-LocationClientTool::validateCb(const shared_ptr<RequestState>& state)
+LocationClientTool::validateCb()
 {
-  if (state->m_status == ChallengeModule::SUCCESS) {
-    NDN_LOG_TRACE("DONE! Certificate has already been issued");
-    client.requestDownload(state,
-                           [this] (const auto& state) {
-                             downloadCb(state);
-                           },
-                           bind(&LocationClientTool::errorCb, this, _1));
+  if (m_state->m_status != ChallengeModule::SUCCESS) {
+    errorCb("Unexpected status `" + m_state->m_status + "` after _VALIDATE");
     return;
   }
+
+  ICEAR_BLOG_TRACE(CERT_ALREADY_ISSUED);
+  startStep(Step::DOWNLOAD);
+  client.requestDownload(m_state, makeRequestCallback(), makeErrorCallback());
 }
 
 void
-LocationClientTool::downloadCb(const shared_ptr<RequestState>& state)
+LocationClientTool::downloadCb()
 {
+  m_step = Step::DONE;
+
   // as a hack: there must be 2 certs now: default self-signed, and the other one we just got. Showing the other one
 
-  Name defaultCertName = state->m_key.getDefaultCertificate().getName();
+  Name defaultCertName = m_state->m_key.getDefaultCertificate().getName();
 
-  for (const auto& cert : state->m_key.getCertificates()) {
+  for (const auto& cert : m_state->m_key.getCertificates()) {
     if (cert.getName() == defaultCertName) {
       continue;
     }
-    NDN_LOG_INFO("Got CERT:" << cert.getName() << "\n" << cert);
+    ICEAR_BLOG_INFO(GOT_CERT, cert.getName(), cert);
 
     onSuccess(cert);
     break;
@@ -5,59 +5,192 @@
 
 #include <ndn-cxx/util/signal.hpp>
 
+#include "ca-verifier-cache.hpp"
+#include "location-challenge-tlv.hpp"
+#include "rtt-estimator.hpp"
+#include "session-arena.hpp"
+
 namespace ndn {
 namespace ndncert {
 
+/**
+ * @brief What the client learned about a CA, kept across bootstrap sessions
+ */
+struct CaContext
+{
+  RttEstimator rtt;
+
+  /// format of the localhop validation exchange; JSON until the CA advertises TLV support
+  LocalhopEncoding localhopEncoding = LocalhopEncoding::JSON;
+  bool isLocalhopEncodingConfirmed = false;
+};
+
+/**
+ * @brief NDNCERT client for the LOCATION challenge
+ *
+ * The request runs as a stackless state machine (PROBE -> SELECT -> LOCALHOP_VALIDATE -> VALIDATE
+ * -> DOWNLOAD): all per-request state lives in the tool, and callbacks capture only `this` and the
+ * request ID, so that stale callbacks of a cancelled or restarted request are ignored.
+ */
 class LocationClientTool
 {
 public:
-  LocationClientTool(Face& face, KeyChain& keyChain, const Name& caPrefix, const Certificate& caCert);
-
+  enum class Step {
+    IDLE,
+    PROBE,
+    SELECT,
+    LOCALHOP_VALIDATE,
+    VALIDATE,
+    DOWNLOAD,
+    DONE
+  };
+
+  /**
+   * @param ca what is known about the CA: its RTT estimator is fed by, and times the
+   *           retransmissions of, localhop validation exchanges, and the negotiated localhop
+   *           encoding is recorded there; must outlive the tool
+   * @param verifiers cache of decoded CA keys used to check CA responses; must outlive the tool
+   * @param arena arena of the bootstrap session, for the scratch of the exchanges (challenge
+   *              codes, serialized localhop validation requests); must outlive the tool
+   */
+  LocationClientTool(Face& face, KeyChain& keyChain, const Name& caPrefix, const Certificate& caCert,
+                     CaContext& ca, CaVerifierCache& verifiers, SessionArena& arena);
+
+  /**
+   * @brief Start a new request, cancelling the one in progress (if any)
+   */
   void
   start(const std::string& userIdentity);
 
+  /**
+   * @brief Cancel the request in progress; neither onSuccess nor onFailure will be emitted for it
+   */
+  void
+  cancel();
+
+  Step
+  getStep() const
+  {
+    return m_step;
+  }
+
+  /**
+   * @brief Send localhop validation Interests out of face @p faceId only
+   *
+   * /localhop/CA may be routed to more than one CA when several of them are in use; pinning the
+   * face (requires local fields to be enabled on the client face) makes sure the validation
+   * reaches the CA that issued the code.  0 leaves the choice to the forwarder.
+   */
+  void
+  setLocalhopFaceId(uint64_t faceId)
+  {
+    m_localhopFaceId = faceId;
+  }
+
+private:
+  ClientModule::RequestCallback
+  makeRequestCallback();
+
+  ClientModule::ErrorCallback
+  makeErrorCallback();
+
+  void
+  onStepSucceeded(const shared_ptr<RequestState>& state);
+
   void
   errorCb(const std::string& errorInfo);
 
   void
-  newCb(const shared_ptr<RequestState>& state);
+  newCb();
 
   void
-  selectCb(const shared_ptr<RequestState>& state);
+  selectCb();
 
   void
-  downloadCb(const shared_ptr<RequestState>& state);
+  localhopValidateCb();
 
   void
-  validateCb(const shared_ptr<RequestState>& state);
+  validateCb();
 
   void
-  localhopValidateCb(const shared_ptr<RequestState>& state);
+  downloadCb();
 
-private:
   void
-  sendLocalhopValidate(const shared_ptr<RequestState>& state,
-                       const JsonSection& validateParams,
-                       const ClientModule::RequestCallback& requestCallback,
-                       const ClientModule::ErrorCallback& errorCallback);
+  sendLocalhopValidate();
+
+  Interest
+  makeLocalhopValidateInterest(LocalhopEncoding encoding);
+
+  void
+  expressLocalhopValidate(size_t nRetriesLeft);
+
+  /**
+   * @brief Fall back to JSON if the CA has not yet answered a TLV request
+   * @return whether the encoding has been switched
+   */
+  bool
+  fallbackToJsonEncoding();
+
+  void
+  handleLocalhopValidateResponse(const Data& reply);
+
+  void
+  handleLocalhopValidateJsonResponse(const Data& reply);
+
+  void
+  handleLocalhopValidateTlvResponse(const Data& reply);
 
   void
-  handleLocalhopValidateResponse(const Interest& request,
-                                 const Data& reply,
-                                 const shared_ptr<RequestState>& state,
-                                 const ClientModule::RequestCallback& requestCallback,
-                                 const ClientModule::ErrorCallback& errorCallback);
+  startStep(Step step);
+
+  void
+  finishStep();
 
 public:
   util::Signal<LocationClientTool, const Certificate&> onSuccess;
   util::Signal<LocationClientTool, const std::string&> onFailure;
 
+  /**
+   * @brief Emitted when the request moves to the next step (including the first one)
+   */
+  util::Signal<LocationClientTool, Step> onStepStarted;
+
 private:
   const std::string LOCATION_CHALLENGE = "LOCATION";
   ClientModule client;
   KeyChain& m_keyChain;
   Face& m_face;
+  CaContext& m_ca;
+  CaVerifierCache& m_verifiers;
+  SessionArena& m_arena;
+
+  uint64_t m_requestId = 0;
+  Step m_step = Step::IDLE;
+  time::steady_clock::TimePoint m_stepStart;
+  shared_ptr<RequestState> m_state;
+  std::string m_localhopCode;
+  JsonSection m_localhopParams;
+  std::string m_encryptedCode2; ///< raw code2 from a TLV response, empty for JSON responses
+  Interest m_localhopInterest;
+  ScopedPendingInterestHandle m_localhopPendingInterest;
+  uint64_t m_localhopFaceId = 0;
 };
 
+/**
+ * @brief Decrypt challenge code with private key @p keyName from the KeyChain's TPM
+ * @return the code, in @p arena
+ */
+ArenaString
+decryptCode(const uint8_t* encrypted, size_t size, KeyChain& keyChain, const Name& keyName,
+            SessionArena& arena);
+
+/**
+ * @brief Decrypt base64-encoded challenge code (as in JSON responses), decoding it in @p arena
+ * @return the code, in @p arena
+ */
+ArenaString
+base64DecodeAndDecryptCode(const std::string& encrypted, KeyChain& keyChain, const Name& keyName,
+                           SessionArena& arena);
+
 } // namespace ndncert
 } // namespace ndn
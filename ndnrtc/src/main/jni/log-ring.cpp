@@ -0,0 +1,216 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#include "log-ring.hpp"
+#include "metrics.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace icear {
+
+const char* const LogRing::FILE_NAME = "ice-ar-log.ring";
+
+static const uint32_t MAGIC = 0x524c4349; // 'ICLR'
+static const uint32_t VERSION = 1;
+static const size_t HEADER_SIZE = 64;
+static const size_t RECORD_HEADER_SIZE = 24;
+static const size_t ALIGNMENT = 8;
+static const size_t MAX_MODULE_SIZE = 255;
+
+struct LogRing::Header
+{
+  uint32_t magic;
+  uint32_t version;
+  uint32_t dataSize;
+  uint32_t reserved;
+  uint64_t head;
+  uint64_t tail;
+  uint64_t sequence;
+};
+
+static size_t
+alignSize(size_t size)
+{
+  return (size + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+}
+
+static uint32_t
+readUint32(const uint8_t* p)
+{
+  uint32_t value;
+  std::memcpy(&value, p, sizeof(value));
+  return value;
+}
+
+static uint16_t
+readUint16(const uint8_t* p)
+{
+  uint16_t value;
+  std::memcpy(&value, p, sizeof(value));
+  return value;
+}
+
+LogRing::LogRing(const std::string& path, size_t dataSize)
+  : m_dataSize(alignSize(dataSize))
+{
+  static_assert(sizeof(Header) <= HEADER_SIZE, "Header must fit into HEADER_SIZE");
+
+  m_fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+  if (m_fd < 0) {
+    throw std::runtime_error("Cannot open log ring " + path + ": " + std::strerror(errno));
+  }
+
+  m_mapSize = HEADER_SIZE + m_dataSize;
+  if (::ftruncate(m_fd, m_mapSize) != 0) {
+    ::close(m_fd);
+    throw std::runtime_error("Cannot resize log ring " + path + ": " + std::strerror(errno));
+  }
+
+  void* map = ::mmap(nullptr, m_mapSize, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0);
+  if (map == MAP_FAILED) {
+    ::close(m_fd);
+    throw std::runtime_error("Cannot map log ring " + path + ": " + std::strerror(errno));
+  }
+
+  m_map = static_cast<uint8_t*>(map);
+  m_header = reinterpret_cast<Header*>(m_map);
+  m_data = m_map + HEADER_SIZE;
+
+  bool isValid = m_header->magic == MAGIC && m_header->version == VERSION &&
+                 m_header->dataSize == m_dataSize && m_header->tail <= m_header->head &&
+                 m_header->head - m_header->tail <= m_dataSize && hasValidRecords();
+  if (!isValid) {
+    std::memset(m_map, 0, HEADER_SIZE);
+    m_header->version = VERSION;
+    m_header->dataSize = static_cast<uint32_t>(m_dataSize);
+    __atomic_store_n(&m_header->magic, MAGIC, __ATOMIC_RELEASE);
+  }
+}
+
+LogRing::~LogRing()
+{
+  ::munmap(m_map, m_mapSize);
+  ::close(m_fd);
+}
+
+bool
+LogRing::isValidRecord(size_t offset) const
+{
+  // records are aligned and never wrap, so the size and type fields are always inside data area
+  const uint8_t* record = m_data + offset;
+  size_t size = readUint32(record);
+  if (size % ALIGNMENT != 0 || size > m_dataSize - offset) {
+    return false;
+  }
+  if (record[4] == PADDING) {
+    return size == m_dataSize - offset;
+  }
+  return size >= RECORD_HEADER_SIZE &&
+         RECORD_HEADER_SIZE + readUint16(record + 6) + readUint32(record + 8) <= size;
+}
+
+bool
+LogRing::hasValidRecords() const
+{
+  uint64_t head = m_header->head;
+  uint64_t offset = m_header->tail;
+  if (head % ALIGNMENT != 0 || offset % ALIGNMENT != 0) {
+    return false;
+  }
+  while (offset < head) {
+    if (!isValidRecord(offset % m_dataSize)) {
+      return false;
+    }
+    offset += readUint32(m_data + offset % m_dataSize);
+  }
+  return offset == head;
+}
+
+uint8_t*
+LogRing::reserve(size_t recordSize)
+{
+  uint64_t head = m_header->head;
+  size_t offset = head % m_dataSize;
+
+  // records never wrap: fill the rest of data area with padding and start over from 0
+  if (offset + recordSize > m_dataSize) {
+    size_t paddingSize = m_dataSize - offset;
+    reserve(paddingSize);
+    uint32_t size = static_cast<uint32_t>(paddingSize);
+    std::memcpy(m_data + offset, &size, sizeof(size));
+    m_data[offset + 4] = PADDING;
+    __atomic_store_n(&m_header->head, head + paddingSize, __ATOMIC_RELEASE);
+    return reserve(recordSize);
+  }
+
+  // evict records that are going to be overwritten; readers only follow the ring, so this counts
+  // the ring's turnover, not records that nobody has read
+  uint64_t tail = m_header->tail;
+  uint64_t nOverwritten = 0;
+  while (tail + m_dataSize < head + recordSize) {
+    const uint8_t* record = m_data + tail % m_dataSize;
+    if (!isValidRecord(tail % m_dataSize) || tail + readUint32(record) > head) {
+      // damaged behind our back (the constructor checked the records): rather than walk
+      // garbage, drop them all; offsets stay monotonic, so the viewer simply skips to the tail
+      tail = head;
+      break;
+    }
+    nOverwritten += record[4] != PADDING;
+    tail += readUint32(record);
+  }
+  if (nOverwritten > 0) {
+    metrics::add(metrics::Counter::LOG_RECORDS_OVERWRITTEN, nOverwritten);
+  }
+  __atomic_store_n(&m_header->tail, tail, __ATOMIC_RELEASE);
+
+  return m_data + offset;
+}
+
+void
+LogRing::append(int severity, const std::string& module, const std::string& message)
+{
+  append(TEXT, severity, module, reinterpret_cast<const uint8_t*>(message.data()), message.size());
+}
+
+void
+LogRing::append(RecordType type, int severity, const std::string& module,
+                const uint8_t* payload, size_t payloadSize)
+{
+  size_t moduleSize = std::min<size_t>(module.size(), MAX_MODULE_SIZE);
+  // a single record may take at most a quarter of the ring
+  payloadSize = std::min(payloadSize, m_dataSize / 4 - RECORD_HEADER_SIZE - moduleSize);
+  size_t recordSize = alignSize(RECORD_HEADER_SIZE + moduleSize + payloadSize);
+
+  uint64_t timestamp = std::chrono::duration_cast<std::chrono::milliseconds>(
+                         std::chrono::system_clock::now().time_since_epoch()).count();
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  uint8_t* record = reserve(recordSize);
+
+  uint32_t size32 = static_cast<uint32_t>(recordSize);
+  uint16_t moduleSize16 = static_cast<uint16_t>(moduleSize);
+  uint32_t payloadSize32 = static_cast<uint32_t>(payloadSize);
+  uint32_t reserved = 0;
+  std::memcpy(record, &size32, 4);
+  record[4] = type;
+  record[5] = static_cast<uint8_t>(severity + 1);
+  std::memcpy(record + 6, &moduleSize16, 2);
+  std::memcpy(record + 8, &payloadSize32, 4);
+  std::memcpy(record + 12, &reserved, 4);
+  std::memcpy(record + 16, &timestamp, 8);
+  std::memcpy(record + RECORD_HEADER_SIZE, module.data(), moduleSize);
+  std::memcpy(record + RECORD_HEADER_SIZE + moduleSize, payload, payloadSize);
+
+  ++m_header->sequence;
+  __atomic_store_n(&m_header->head, m_header->head + recordSize, __ATOMIC_RELEASE);
+}
+
+} // namespace icear
@@ -0,0 +1,109 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#ifndef ICEAR_LOG_RING_HPP
+#define ICEAR_LOG_RING_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+namespace icear {
+
+/**
+ * @brief Fixed-size, memory-mapped ring of log records
+ *
+ * The ring lives in a file, so records survive a process crash, and the Java viewer maps the
+ * same file read-only and decodes only the records it shows.  Layout (host byte order; must
+ * match LogRing.java):
+ *
+ *     Header (64 octets)
+ *       0  uint32 magic ('ICLR')
+ *       4  uint32 version
+ *       8  uint32 data size
+ *      16  uint64 head      ; monotonic offset where the next record is written
+ *      24  uint64 tail      ; monotonic offset of the oldest complete record
+ *      32  uint64 sequence  ; number of records ever written
+ *     Data (data size octets), records aligned to 8 octets
+ *       0  uint32 record size (including this header and padding)
+ *       4  uint8  type      ; PADDING (fill up to the end of data area), TEXT or BINARY
+ *       5  uint8  severity  ; ndn::util::LogLevel + 1
+ *       6  uint16 module size
+ *       8  uint32 payload size
+ *      16  uint64 timestamp ; milliseconds since Unix epoch
+ *      24  module, payload (message text or binary record)
+ *
+ * The writer moves the tail past records before overwriting them and publishes head after the
+ * record is complete, so a reader can discard anything that fell behind the tail while decoding.
+ */
+class LogRing
+{
+public:
+  enum RecordType : uint8_t {
+    PADDING = 0,
+    TEXT = 1,
+    BINARY = 2 ///< payload encoded by blog::Encoder, see binary-log.hpp
+  };
+
+  static const char* const FILE_NAME;
+
+  /**
+   * @brief Open (or create) ring file at @p path
+   *
+   * An existing file with matching layout and intact records is reused, keeping its records;
+   * otherwise (e.g., the file is damaged or of an older format) the ring starts empty.
+   * @throw std::runtime_error the file cannot be created or mapped
+   */
+  LogRing(const std::string& path, size_t dataSize = 1024 * 1024);
+
+  ~LogRing();
+
+  LogRing(const LogRing&) = delete;
+
+  LogRing&
+  operator=(const LogRing&) = delete;
+
+  /**
+   * @brief Append text record; safe to call from any thread
+   */
+  void
+  append(int severity, const std::string& module, const std::string& message);
+
+  /**
+   * @brief Append record with pre-encoded payload
+   */
+  void
+  append(RecordType type, int severity, const std::string& module,
+         const uint8_t* payload, size_t payloadSize);
+
+private:
+  struct Header;
+
+  uint8_t*
+  reserve(size_t recordSize);
+
+  /**
+   * @brief Check the sizes of the record at @p offset in the data area, as found in the file
+   */
+  bool
+  isValidRecord(size_t offset) const;
+
+  /**
+   * @brief Check that the records from tail to head are intact and end exactly at head
+   */
+  bool
+  hasValidRecords() const;
+
+private:
+  std::mutex m_mutex;
+  int m_fd = -1;
+  uint8_t* m_map = nullptr;
+  size_t m_mapSize = 0;
+  Header* m_header = nullptr;
+  uint8_t* m_data = nullptr;
+  size_t m_dataSize = 0;
+};
+
+} // namespace icear
+
+#endif // ICEAR_LOG_RING_HPP
@@ -0,0 +1,240 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#include "loop-monitor.hpp"
+#include "binary-log.hpp"
+
+#include <boost/stacktrace.hpp>
+
+#include <csignal>
+#include <sstream>
+
+namespace ndn {
+namespace ndncert {
+
+NDN_LOG_INIT(ndncert.LoopMonitor);
+
+constexpr size_t LoopMonitor::N_LAG_BUCKETS;
+
+// otherwise unused by the app and the runtime; delivered to the loop thread only
+static const int STALL_SIGNAL = SIGURG;
+static const time::milliseconds STACK_CAPTURE_TIMEOUT = time::milliseconds(100);
+
+// Shared by all monitors of the process, as the signal handler is: g_stallCaptureMutex lets one
+// capture at a time request a dump, and the sequence numbers tell the requester whether the dump
+// is the one it asked for, rather than a late answer to an earlier, timed out request.
+static std::mutex g_stallCaptureMutex;
+static pthread_t g_stallThread; // written before the signal is sent
+static std::atomic<uint32_t> g_requestedDump{0}; // 32-bit, to be lock-free in the handler everywhere
+static std::atomic<uint32_t> g_completedDump{0};
+static char g_stallDump[8192];
+
+static void
+onStallSignal(int)
+{
+  uint32_t sequence = g_requestedDump.load();
+  if (!pthread_equal(pthread_self(), g_stallThread) || g_completedDump.load() == sequence) {
+    return;
+  }
+  boost::stacktrace::safe_dump_to(g_stallDump, sizeof(g_stallDump));
+  g_completedDump.store(sequence);
+}
+
+static int64_t
+toNanoseconds(time::steady_clock::TimePoint tp)
+{
+  return time::duration_cast<time::nanoseconds>(tp.time_since_epoch()).count();
+}
+
+LoopMonitor::LoopMonitor(boost::asio::io_service& ioService)
+  : LoopMonitor(ioService, Options())
+{
+}
+
+LoopMonitor::LoopMonitor(boost::asio::io_service& ioService, const Options& options)
+  : m_options(options)
+  , m_timer(ioService)
+  , m_loopThread(pthread_self())
+{
+}
+
+LoopMonitor::~LoopMonitor()
+{
+  stop();
+}
+
+size_t
+LoopMonitor::getLagBucket(time::microseconds lag)
+{
+  int64_t ms = lag.count() / 1000;
+  size_t bucket = 0;
+  while (ms > 0 && bucket + 1 < N_LAG_BUCKETS) {
+    ms >>= 1;
+    ++bucket;
+  }
+  return bucket;
+}
+
+void
+LoopMonitor::start()
+{
+  if (m_options.isStackCaptureEnabled) {
+    static std::once_flag isHandlerInstalled;
+    std::call_once(isHandlerInstalled, [] {
+        struct sigaction action = {};
+        action.sa_handler = &onStallSignal;
+        action.sa_flags = SA_RESTART;
+        sigemptyset(&action.sa_mask);
+        sigaction(STALL_SIGNAL, &action, nullptr);
+      });
+  }
+
+  m_loopThread = pthread_self();
+  {
+    std::lock_guard<std::mutex> lock(m_watchdogMutex);
+    m_isStopping = false;
+  }
+  if (!m_watchdog.joinable()) {
+    m_watchdog = std::thread([this] { runWatchdog(); });
+  }
+}
+
+void
+LoopMonitor::stop()
+{
+  m_timer.cancel();
+  m_isProbeScheduled = false;
+  m_probeDueNs.store(0);
+
+  {
+    std::lock_guard<std::mutex> lock(m_watchdogMutex);
+    m_isStopping = true;
+    m_isWatching = false;
+  }
+  m_watchdogCv.notify_all();
+  if (m_watchdog.joinable()) {
+    m_watchdog.join();
+  }
+}
+
+void
+LoopMonitor::watch()
+{
+  m_watchUntil = time::steady_clock::now() + m_options.watchPeriod;
+  {
+    std::lock_guard<std::mutex> lock(m_watchdogMutex);
+    m_isWatching = true;
+  }
+  m_watchdogCv.notify_all();
+
+  if (!m_isProbeScheduled) {
+    scheduleProbe();
+  }
+}
+
+void
+LoopMonitor::scheduleProbe()
+{
+  auto now = time::steady_clock::now();
+  if (now >= m_watchUntil) {
+    m_isProbeScheduled = false;
+    m_probeDueNs.store(0);
+    std::lock_guard<std::mutex> lock(m_watchdogMutex);
+    m_isWatching = false;
+    return;
+  }
+
+  m_isProbeScheduled = true;
+  m_probeDue = now + m_options.probeInterval;
+  m_probeDueNs.store(toNanoseconds(m_probeDue));
+  m_timer.expires_at(m_probeDue);
+  m_timer.async_wait([this] (const boost::system::error_code& error) {
+      if (error) {
+        return;
+      }
+      onProbe();
+    });
+}
+
+void
+LoopMonitor::onProbe()
+{
+  auto lag = time::duration_cast<time::microseconds>(time::steady_clock::now() - m_probeDue);
+  {
+    std::lock_guard<std::mutex> lock(m_statsMutex);
+    ++m_stats.lagHistogram[getLagBucket(lag)];
+    ++m_stats.nProbes;
+    m_stats.totalLag += lag;
+    m_stats.maxLag = std::max(m_stats.maxLag, lag);
+  }
+  scheduleProbe();
+}
+
+void
+LoopMonitor::runWatchdog()
+{
+  int64_t lastReportedDue = 0;
+
+  std::unique_lock<std::mutex> lock(m_watchdogMutex);
+  while (!m_isStopping) {
+    if (!m_isWatching) {
+      m_watchdogCv.wait(lock);
+      continue;
+    }
+    m_watchdogCv.wait_for(lock, std::chrono::milliseconds(m_options.stallThreshold.count() / 2));
+
+    int64_t due = m_probeDueNs.load();
+    if (due == 0 || due == lastReportedDue) {
+      continue;
+    }
+    time::nanoseconds overdue(toNanoseconds(time::steady_clock::now()) - due);
+    if (overdue > m_options.stallThreshold) {
+      lastReportedDue = due; // one report per stall
+      lock.unlock();
+      captureStall(overdue);
+      lock.lock();
+    }
+  }
+}
+
+void
+LoopMonitor::captureStall(time::nanoseconds overdue)
+{
+  std::string stack = "(stack capture disabled)";
+  if (m_options.isStackCaptureEnabled) {
+    std::lock_guard<std::mutex> lock(g_stallCaptureMutex);
+    stack = "(stack not captured)";
+    g_stallThread = m_loopThread;
+    uint32_t sequence = g_requestedDump.load() + 1;
+    g_requestedDump.store(sequence);
+    if (pthread_kill(m_loopThread, STALL_SIGNAL) == 0) {
+      auto deadline = time::steady_clock::now() + STACK_CAPTURE_TIMEOUT;
+      while (g_completedDump.load() != sequence && time::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      }
+      if (g_completedDump.load() == sequence) {
+        std::ostringstream os;
+        os << boost::stacktrace::stacktrace::from_dump(g_stallDump, sizeof(g_stallDump));
+        stack = os.str();
+      }
+    }
+  }
+
+  auto duration = time::duration_cast<time::milliseconds>(overdue);
+  ICEAR_BLOG_WARN(LOOP_STALL, duration, stack);
+
+  std::lock_guard<std::mutex> lock(m_statsMutex);
+  ++m_stats.nStalls;
+  m_stats.lastStall.time = time::system_clock::now();
+  m_stats.lastStall.duration = duration;
+  m_stats.lastStall.stack = std::move(stack);
+}
+
+LoopMonitor::Stats
+LoopMonitor::getStats() const
+{
+  std::lock_guard<std::mutex> lock(m_statsMutex);
+  return m_stats;
+}
+
+} // namespace ndncert
+} // namespace ndn
@@ -0,0 +1,149 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#ifndef ICEAR_LOOP_MONITOR_HPP
+#define ICEAR_LOOP_MONITOR_HPP
+
+#include <ndn-cxx/util/detail/steady-timer.hpp>
+#include <ndn-cxx/util/noncopyable.hpp>
+#include <ndn-cxx/util/time.hpp>
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include <pthread.h>
+
+namespace ndn {
+namespace ndncert {
+
+/**
+ * @brief Measures scheduling delay of an io_service loop and catches the handlers that stall it
+ *
+ * While watching, a probe timer fires every probeInterval on the loop, and the delay between its
+ * expiry and the moment its handler runs goes into a histogram.  A watchdog thread checks on the
+ * probe; once it is overdue by more than stallThreshold, the stall is counted.  With stack
+ * capture enabled, the loop thread is also interrupted with a signal (SIGURG, whose handler is
+ * installed on first use) and its stack is captured, which shows the handler that is running.
+ * Handlers restart interrupted system calls, except those that never restart (e.g., sleeps,
+ * which return early).  Captures of all monitors in the process share one buffer and are taken
+ * one at a time.
+ *
+ * Probing is limited to watchPeriod after each watch() call (e.g., around a bootstrap), so that an
+ * idle loop is not woken up just to be measured.
+ */
+class LoopMonitor : noncopyable
+{
+public:
+  struct Options
+  {
+    time::milliseconds probeInterval = time::milliseconds(100);
+    time::milliseconds stallThreshold = time::milliseconds(250);
+    time::seconds watchPeriod = time::seconds(60);
+    bool isStackCaptureEnabled = false;
+  };
+
+  /// lag histogram buckets: < 1 ms, [1, 2) ms, [2, 4) ms, ..., [512, 1024) ms, >= 1024 ms
+  static constexpr size_t N_LAG_BUCKETS = 12;
+
+  struct Stall
+  {
+    time::system_clock::TimePoint time;
+    time::milliseconds duration; ///< how long the loop had been stuck when the stack was taken
+    std::string stack;
+  };
+
+  struct Stats
+  {
+    std::array<uint64_t, N_LAG_BUCKETS> lagHistogram{};
+    uint64_t nProbes = 0;
+    time::microseconds totalLag{0};
+    time::microseconds maxLag{0};
+    uint64_t nStalls = 0;
+    Stall lastStall;
+  };
+
+  explicit
+  LoopMonitor(boost::asio::io_service& ioService);
+
+  LoopMonitor(boost::asio::io_service& ioService, const Options& options);
+
+  ~LoopMonitor();
+
+  /**
+   * @brief Enable or disable capture of the loop thread's stack on stalls; takes effect on start()
+   */
+  void
+  setStackCaptureEnabled(bool isEnabled)
+  {
+    m_options.isStackCaptureEnabled = isEnabled;
+  }
+
+  /**
+   * @brief Start the watchdog; must be called on the thread that runs the loop
+   */
+  void
+  start();
+
+  void
+  stop();
+
+  /**
+   * @brief Probe the loop for the next watchPeriod
+   */
+  void
+  watch();
+
+  /**
+   * @brief Copy of the statistics; can be called from any thread
+   */
+  Stats
+  getStats() const;
+
+  /**
+   * @return index of the histogram bucket for @p lag
+   */
+  static size_t
+  getLagBucket(time::microseconds lag);
+
+private:
+  void
+  scheduleProbe();
+
+  void
+  onProbe();
+
+  void
+  runWatchdog();
+
+  void
+  captureStall(time::nanoseconds overdue);
+
+private:
+  Options m_options;
+  util::detail::SteadyTimer m_timer;
+  pthread_t m_loopThread;
+
+  // loop thread
+  time::steady_clock::TimePoint m_watchUntil;
+  time::steady_clock::TimePoint m_probeDue;
+  bool m_isProbeScheduled = false;
+
+  // shared with the watchdog
+  std::atomic<int64_t> m_probeDueNs{0}; ///< steady clock time of the pending probe, 0 if none
+  std::mutex m_watchdogMutex;
+  std::condition_variable m_watchdogCv;
+  bool m_isWatching = false;
+  bool m_isStopping = false;
+  std::thread m_watchdog;
+
+  mutable std::mutex m_statsMutex;
+  Stats m_stats;
+};
+
+} // namespace ndncert
+} // namespace ndn
+
+#endif // ICEAR_LOOP_MONITOR_HPP
@@ -0,0 +1,149 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#include "metrics.hpp"
+
+#include <atomic>
+#include <cstring>
+
+namespace icear {
+namespace metrics {
+
+static const uint32_t MAGIC = 0x544d4349; // 'ICMT'
+static const uint16_t VERSION = 1;
+static const size_t HEADER_SIZE = 24;
+
+#define ICEAR_METRICS_COUNT(id) + 1
+static const size_t N_COUNTERS = 0 ICEAR_METRICS_COUNTERS(ICEAR_METRICS_COUNT);
+static const size_t N_GAUGES = 0 ICEAR_METRICS_GAUGES(ICEAR_METRICS_COUNT);
+static const size_t N_HISTOGRAMS = 0 ICEAR_METRICS_HISTOGRAMS(ICEAR_METRICS_COUNT);
+#undef ICEAR_METRICS_COUNT
+
+// enough for the I/O thread, JNI callers and the logging threads not to share a shard
+static const size_t N_SHARDS = 8;
+
+struct alignas(64) Shard
+{
+  std::atomic<uint64_t> counters[N_COUNTERS];
+  std::atomic<uint64_t> sums[N_HISTOGRAMS]; // microseconds
+  std::atomic<uint64_t> buckets[N_HISTOGRAMS][N_HISTOGRAM_BUCKETS];
+};
+
+// zero-initialized static storage
+static Shard g_shards[N_SHARDS];
+static std::atomic<int64_t> g_gauges[N_GAUGES];
+static std::atomic<size_t> g_nextShard{0};
+
+static Shard&
+getShard()
+{
+  static thread_local Shard& shard = g_shards[g_nextShard.fetch_add(1, std::memory_order_relaxed) % N_SHARDS];
+  return shard;
+}
+
+static size_t
+getBucket(ndn::time::nanoseconds value)
+{
+  int64_t ms = ndn::time::duration_cast<ndn::time::milliseconds>(value).count();
+  size_t bucket = 0;
+  while (ms > 0 && bucket + 1 < N_HISTOGRAM_BUCKETS) {
+    ms >>= 1;
+    ++bucket;
+  }
+  return bucket;
+}
+
+void
+add(Counter counter, uint64_t n)
+{
+  getShard().counters[static_cast<size_t>(counter)].fetch_add(n, std::memory_order_relaxed);
+}
+
+void
+set(Gauge gauge, int64_t value)
+{
+  g_gauges[static_cast<size_t>(gauge)].store(value, std::memory_order_relaxed);
+}
+
+void
+record(Histogram histogram, ndn::time::nanoseconds value)
+{
+  if (value < ndn::time::nanoseconds::zero()) {
+    value = ndn::time::nanoseconds::zero();
+  }
+
+  auto index = static_cast<size_t>(histogram);
+  Shard& shard = getShard();
+  shard.sums[index].fetch_add(ndn::time::duration_cast<ndn::time::microseconds>(value).count(),
+                              std::memory_order_relaxed);
+  shard.buckets[index][getBucket(value)].fetch_add(1, std::memory_order_relaxed);
+}
+
+template<typename T>
+static void
+append(std::vector<uint8_t>& buffer, T value)
+{
+  size_t offset = buffer.size();
+  buffer.resize(offset + sizeof(value));
+  std::memcpy(buffer.data() + offset, &value, sizeof(value));
+}
+
+template<typename T>
+static uint64_t
+sumShards(T Shard::* field, size_t index)
+{
+  uint64_t sum = 0;
+  for (const auto& shard : g_shards) {
+    sum += (shard.*field)[index].load(std::memory_order_relaxed);
+  }
+  return sum;
+}
+
+std::vector<uint8_t>
+snapshot()
+{
+  std::vector<uint8_t> buffer;
+  buffer.reserve(HEADER_SIZE + 8 * (N_COUNTERS + N_GAUGES + N_HISTOGRAMS * (1 + N_HISTOGRAM_BUCKETS)));
+
+  append<uint32_t>(buffer, MAGIC);
+  append<uint16_t>(buffer, VERSION);
+  append<uint16_t>(buffer, N_COUNTERS);
+  append<uint16_t>(buffer, N_GAUGES);
+  append<uint16_t>(buffer, N_HISTOGRAMS);
+  append<uint16_t>(buffer, N_HISTOGRAM_BUCKETS);
+  append<uint16_t>(buffer, 0);
+  append<uint64_t>(buffer, ndn::time::toUnixTimestamp(ndn::time::system_clock::now()).count());
+
+  for (size_t i = 0; i < N_COUNTERS; ++i) {
+    append<uint64_t>(buffer, sumShards(&Shard::counters, i));
+  }
+  for (size_t i = 0; i < N_GAUGES; ++i) {
+    append<int64_t>(buffer, g_gauges[i].load(std::memory_order_relaxed));
+  }
+  for (size_t i = 0; i < N_HISTOGRAMS; ++i) {
+    append<uint64_t>(buffer, sumShards(&Shard::sums, i));
+    for (size_t bucket = 0; bucket < N_HISTOGRAM_BUCKETS; ++bucket) {
+      uint64_t count = 0;
+      for (const auto& shard : g_shards) {
+        count += shard.buckets[i][bucket].load(std::memory_order_relaxed);
+      }
+      append<uint64_t>(buffer, count);
+    }
+  }
+
+  return buffer;
+}
+
+std::vector<const char*>
+getNames()
+{
+#define ICEAR_METRICS_NAME(id) #id,
+  return {
+    ICEAR_METRICS_COUNTERS(ICEAR_METRICS_NAME)
+    ICEAR_METRICS_GAUGES(ICEAR_METRICS_NAME)
+    ICEAR_METRICS_HISTOGRAMS(ICEAR_METRICS_NAME)
+  };
+#undef ICEAR_METRICS_NAME
+}
+
+} // namespace metrics
+} // namespace icear
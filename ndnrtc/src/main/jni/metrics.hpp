@@ -0,0 +1,115 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#ifndef ICEAR_METRICS_HPP
+#define ICEAR_METRICS_HPP
+
+#include <ndn-cxx/util/time.hpp>
+
+#include <cstdint>
+#include <vector>
+
+/**
+ * Metrics of the process; the position in each list is the position in the snapshot, so
+ * metrics may only be appended
+ */
+#define ICEAR_METRICS_COUNTERS(X) \
+  X(DISCOVERY_ATTEMPTS) \
+  X(DISCOVERY_NACKS) \
+  X(DISCOVERY_TIMEOUTS) \
+  X(FIB_POLLS) \
+  X(ROUTE_REGISTRATIONS) \
+  X(ROUTE_REGISTRATION_FAILURES) \
+  X(NDNCERT_STEP_FAILURES) \
+  X(CERTIFICATES_ISSUED) \
+  X(LOG_RECORDS_OVERWRITTEN) \
+  X(NETWORK_EVENTS) \
+  X(NETWORK_CHANGES) \
+  X(CA_CACHE_HITS) \
+  X(CA_CACHE_MISSES)
+
+#define ICEAR_METRICS_GAUGES(X) \
+  X(BOOTSTRAP_STATE) \
+  X(ROUTE_LEASES) \
+  X(SESSION_ARENA_ALLOCATIONS) \
+  X(SESSION_ARENA_BYTES) \
+  X(SESSION_ARENA_HEAP_CHUNKS)
+
+#define ICEAR_METRICS_HISTOGRAMS(X) \
+  X(ISSUANCE_LATENCY) \
+  X(NDNCERT_STEP_LATENCY)
+
+namespace icear {
+namespace metrics {
+
+#define ICEAR_METRICS_ID(id) id,
+
+enum class Counter : uint16_t {
+  ICEAR_METRICS_COUNTERS(ICEAR_METRICS_ID)
+};
+
+enum class Gauge : uint16_t {
+  ICEAR_METRICS_GAUGES(ICEAR_METRICS_ID)
+};
+
+enum class Histogram : uint16_t {
+  ICEAR_METRICS_HISTOGRAMS(ICEAR_METRICS_ID)
+};
+
+#undef ICEAR_METRICS_ID
+
+/// histogram buckets: < 1 ms, [1, 2) ms, [2, 4) ms, ..., [8192, 16384) ms, >= 16384 ms
+const size_t N_HISTOGRAM_BUCKETS = 16;
+
+/**
+ * @brief Add @p n to counter @p counter; lock-free, can be called from any thread
+ *
+ * Counters and histograms are sharded: each thread updates one of several cache-line sized
+ * shards with relaxed atomics, and only a snapshot adds the shards up.
+ */
+void
+add(Counter counter, uint64_t n = 1);
+
+/**
+ * @brief Set gauge @p gauge to @p value; lock-free
+ */
+void
+set(Gauge gauge, int64_t value);
+
+/**
+ * @brief Add @p value to histogram @p histogram; lock-free
+ */
+void
+record(Histogram histogram, ndn::time::nanoseconds value);
+
+/**
+ * @brief Take a snapshot of all metrics
+ *
+ *     Header (24 octets)
+ *       0  uint32 magic ('ICMT')
+ *       4  uint16 version
+ *       6  uint16 number of counters
+ *       8  uint16 number of gauges
+ *      10  uint16 number of histograms
+ *      12  uint16 buckets per histogram
+ *      14  uint16 reserved
+ *      16  uint64 timestamp ; milliseconds since Unix epoch
+ *     uint64 value of each counter
+ *     int64 value of each gauge
+ *     for each histogram: uint64 sum of values in microseconds, uint64 count of each bucket
+ *
+ * All integers are in host byte order.  Shards are read without stopping the writers, so the
+ * metrics are not captured at one instant, but each value is a valid past value.
+ */
+std::vector<uint8_t>
+snapshot();
+
+/**
+ * @brief Names of counters, gauges and histograms, in snapshot order
+ */
+std::vector<const char*>
+getNames();
+
+} // namespace metrics
+} // namespace icear
+
+#endif // ICEAR_METRICS_HPP
@@ -1,6 +1,8 @@
 /* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
 
 #include "mobile-terminal.hpp"
+#include "binary-log.hpp"
+#include "metrics.hpp"
 
 #include <ndn-cxx/encoding/tlv-nfd.hpp>
 #include <ndn-cxx/lp/tags.hpp>
@@ -26,12 +28,30 @@ static const Name HUB_DISCOVERY_PREFIX("/localhop/ndn-autoconf/CA");
 static const uint64_t ROUTE_COST(1);
 static const time::milliseconds ROUTE_EXPIRATION = 160_s;
 static const time::milliseconds HUB_DISCOVERY_INTEREST_LIFETIME = 2_s;
+static const time::milliseconds CACHED_CA_MIN_INTEREST_LIFETIME = 100_ms;
+static const size_t HUB_DISCOVERY_RETRIES = 3;
+static const time::milliseconds ROUTE_WITHDRAW_TIMEOUT = 1_s;
 
-MobileTerminal::MobileTerminal(KeyChain& keyChain, const std::function<bool()>& filterNetworkChange)
+// how late each kind of timer may fire, so that it can share a wakeup with other timers
+static const time::milliseconds FIB_POLL_SLACK = 20_ms;
+static const time::milliseconds NETWORK_CHANGE_SLACK = 1_s;
+static const time::milliseconds DISCOVERY_BACKOFF_SLACK = 250_ms;
+static const time::milliseconds RERUN_SLACK = 10_s;
+
+// hedged issuance: a step is late once it exceeds this percentile of its previous durations
+static const double HEDGE_PERCENTILE = 0.9;
+static const size_t HEDGE_MIN_SAMPLES = 5;
+static const time::milliseconds HEDGE_DEFAULT_STEP_DEADLINE = 2_s;
+static const time::milliseconds HEDGE_MIN_STEP_DEADLINE = 100_ms;
+
+MobileTerminal::MobileTerminal(KeyChain& keyChain, const std::function<bool()>& filterNetworkChange,
+                               shared_ptr<Transport> transport)
   : m_keyChain(keyChain)
-  , m_face(nullptr, m_keyChain)
+  , m_face(std::move(transport), m_keyChain)
   , m_controller(m_face, m_keyChain)
-  , m_scheduler(m_face.getIoService())
+  , m_timers(m_face.getIoService())
+  , m_loopMonitor(m_face.getIoService())
+  , m_routes(m_controller, m_timers, ROUTE_COST, ROUTE_EXPIRATION)
   , m_filterNetworkChange(filterNetworkChange)
 {
 }
@@ -40,26 +60,35 @@ void
 MobileTerminal::doStart()
 {
   m_networkMonitor = std::make_unique<net::NetworkMonitor>(m_face.getIoService());
+  m_networkFilter = std::make_unique<NetworkChangeFilter>(*m_networkMonitor, m_face.getIoService());
 
-  m_networkMonitor->onNetworkStateChanged.connect([this] () {
-      m_rerunEvent = m_scheduler.schedule(5_s, [this] {
+  m_networkFilter->onNetworkChanged.connect([this] (const std::string&) {
+      m_rerunEvent = m_timers.schedule(5_s, NETWORK_CHANGE_SLACK, [this] {
           // NDN_LOG_DEBUG("Detected network state change");
           if (m_filterNetworkChange()) {
             // NDN_LOG_DEBUG("Do nothing (filtered in the up-call)");
             return;
           }
           else {
-            NDN_LOG_INFO("Detected AP change. Re-run NDNCERT");
+            ICEAR_BLOG_INFO(AP_CHANGE);
           }
 
-          m_pi.cancel();
-          m_wait.cancel();
-          m_face.shutdown(); // hopefully, this will stop the process so we ready to re-run...
           runDiscoveryAndNdncert();
         });
     });
 
-  runDiscoveryAndNdncert();
+  m_loopMonitor.start();
+  if (!m_interface.empty() &&
+      (m_networkMonitor->getCapabilities() & net::NetworkMonitor::CAP_ENUM) != 0) {
+    // faces are matched to the interface by its addresses
+    m_enumerationConnection = m_networkMonitor->onEnumerationCompleted.connect([this] {
+        m_enumerationConnection.disconnect();
+        runDiscoveryAndNdncert();
+      });
+  }
+  else {
+    runDiscoveryAndNdncert();
+  }
 
   m_face.processEvents(); // will block until doStop
 }
@@ -67,194 +96,483 @@ MobileTerminal::doStart()
 void
 MobileTerminal::doStop()
 {
-  m_scheduler.cancelAllEvents();
+  m_isStopping = true;
+  cancelSession();
+  m_timers.cancelAll();
+  m_loopMonitor.stop();
+  const auto& timerStats = m_timers.getStats();
+  ICEAR_BLOG_INFO(TIMER_STATS, timerStats.nWakeups, timerStats.nFired,
+                  static_cast<uint64_t>(timerStats.getWakeupsPerHour()));
+  m_enumerationConnection.disconnect();
+  m_networkFilter.reset();
   m_networkMonitor.reset();
-  m_face.shutdown();
+
+  // routes are torn down explicitly, rather than left to linger until they expire
+  m_routes.withdrawAll([this] {
+      m_face.shutdown();
+    }, ROUTE_WITHDRAW_TIMEOUT);
+}
+
+void
+MobileTerminal::stop()
+{
+  if (m_isStopping.exchange(true)) {
+    return;
+  }
+  m_face.getIoService().post([this] {
+      doStop();
+    });
+}
+
+void
+MobileTerminal::restart(bool isHedgingEnabled)
+{
+  m_face.getIoService().post([this, isHedgingEnabled] {
+      if (m_isStopping) {
+        return;
+      }
+      ICEAR_BLOG_INFO(RESTART);
+      m_isHedgingEnabled = isHedgingEnabled;
+      m_rerunEvent.cancel();
+      runDiscoveryAndNdncert();
+    });
 }
 
 void
 MobileTerminal::runDiscoveryAndNdncert()
 {
+  cancelSession();
+  // bootstrap is when loop stalls hurt, so the loop is probed only around it
+  m_loopMonitor.watch();
+
+  m_session = m_arena.create<Session>(m_arena);
+  m_session->id = ++m_lastSessionId;
+  m_session->startTime = time::steady_clock::now();
+  m_session->network = m_network;
+  m_session->state = BootstrapState::ENABLE_LOCAL_FIELDS;
+
+  ICEAR_BLOG_TRACE(SESSION_START, m_session->id);
+  step();
+}
+
+void
+MobileTerminal::cancelSession()
+{
+  if (m_session == nullptr) {
+    return;
+  }
+
+  ICEAR_BLOG_TRACE(SESSION_CANCEL, m_session->id, static_cast<int>(m_session->state));
+  // the next session takes over the routes it registers again, the others lapse
+  m_routes.releaseSession(m_session->id);
+
+  // pending controller commands and timers are keyed to the session ID and become no-ops
+  m_session = nullptr;
+  const SessionArena::Stats& arenaStats = m_arena.getStats();
+  ICEAR_BLOG_DEBUG(SESSION_ARENA_STATS, arenaStats.nAllocations, arenaStats.nBytes,
+                   arenaStats.nHeapChunks);
+  icear::metrics::set(icear::metrics::Gauge::SESSION_ARENA_ALLOCATIONS, static_cast<int64_t>(arenaStats.nAllocations));
+  icear::metrics::set(icear::metrics::Gauge::SESSION_ARENA_BYTES, static_cast<int64_t>(arenaStats.nBytes));
+  icear::metrics::set(icear::metrics::Gauge::SESSION_ARENA_HEAP_CHUNKS, static_cast<int64_t>(arenaStats.nHeapChunks));
+  {
+    std::lock_guard<std::mutex> lock(m_arenaStatsMutex);
+    m_lastSessionArenaStats = arenaStats;
+  }
+  m_arena.release();
+  m_pi.cancel();
+  m_wait.cancel();
+  m_onSuccessConnection.disconnect();
+  m_onFailConnection.disconnect();
+  m_onStepConnection.disconnect();
+  m_primaryClock = StepClock();
+  m_stepDeadline.cancel();
+  m_hedgePi.cancel();
+
+  if (m_ndncertTool != nullptr || m_hedge != nullptr) {
+    if (m_ndncertTool != nullptr) {
+      m_ndncertTool->cancel();
+    }
+    if (m_hedge != nullptr && m_hedge->tool != nullptr) {
+      m_hedge->tool->cancel();
+    }
+
+    // ClientModule binds its callbacks directly to the tool, so the tool may only go away after
+    // Face has dropped its pending Interests; both are posted and run in this order
+    m_face.shutdown();
+    std::shared_ptr<LocationClientTool> tool(std::move(m_ndncertTool));
+    std::shared_ptr<Hedge> hedge(std::move(m_hedge));
+    m_face.getIoService().post([tool, hedge] {});
+  }
+}
+
+void
+MobileTerminal::resume(uint64_t sessionId)
+{
+  if (!isCurrentSession(sessionId)) {
+    return; // stale completion of a cancelled session
+  }
+  step();
+}
+
+void
+MobileTerminal::step()
+{
+  BOOST_ASSERT(m_session != nullptr);
+  Session& session = *m_session;
+  icear::metrics::set(icear::metrics::Gauge::BOOTSTRAP_STATE, static_cast<int64_t>(session.state));
+
+  switch (session.state) {
+  case BootstrapState::ENABLE_LOCAL_FIELDS:
+    session.state = BootstrapState::SYNC_ROUTES;
+    enableLocalFields();
+    break;
+  case BootstrapState::SYNC_ROUTES: {
+    session.state = BootstrapState::QUERY_FACES;
+    uint64_t id = session.id;
+    m_routes.syncWithRib([this, id] {
+        resume(id);
+      });
+    break;
+  }
+  case BootstrapState::QUERY_FACES:
+    session.state = BootstrapState::DISCOVER_CACHED_CA;
+    queryMultiAccessFaces();
+    break;
+  case BootstrapState::DISCOVER_CACHED_CA:
+    session.state = BootstrapState::REGISTER_DISCOVERY_PREFIX;
+    if (!requestCachedCa()) {
+      step();
+    }
+    break;
+  case BootstrapState::REGISTER_DISCOVERY_PREFIX:
+    if (session.nextFace < session.multiAccessFaces.size()) {
+      // stay in this state until the prefix is registered on every multi-access face
+      registerPrefixAndEnsureFibEntry(HUB_DISCOVERY_PREFIX, session.multiAccessFaces[session.nextFace++]);
+    }
+    else {
+      session.state = BootstrapState::SET_STRATEGY;
+      step();
+    }
+    break;
+  case BootstrapState::SET_STRATEGY:
+    session.state = BootstrapState::DISCOVER_CA;
+    session.nDiscoveryRetriesLeft = HUB_DISCOVERY_RETRIES;
+    setStrategy();
+    break;
+  case BootstrapState::DISCOVER_CA:
+    requestHubData();
+    break;
+  case BootstrapState::REGISTER_CA_PREFIX:
+    ICEAR_BLOG_WARN(REQUEST_CERT_FROM_CA, session.caName);
+    session.state = BootstrapState::REGISTER_LOCALHOP_CA_PREFIX;
+    registerPrefixAndEnsureFibEntry(session.caName, session.caFaceId);
+    break;
+  case BootstrapState::REGISTER_LOCALHOP_CA_PREFIX:
+    session.state = BootstrapState::NDNCERT;
+    registerPrefixAndEnsureFibEntry("/localhop/CA", session.caFaceId);
+    break;
+  case BootstrapState::NDNCERT:
+    runNdncert();
+    break;
+  case BootstrapState::DONE:
+    break;
+  }
+}
+
+void
+MobileTerminal::enableLocalFields()
+{
+  uint64_t id = m_session->id;
   m_controller.start<nfd::FaceUpdateCommand>(
     nfd::ControlParameters()
       .setFlagBit(nfd::FaceFlagBit::BIT_LOCAL_FIELDS_ENABLED, true),
-    [this] (const auto&...) {
-      nfd::FaceQueryFilter filter;
-      filter.setLinkType(nfd::LINK_TYPE_MULTI_ACCESS);
-
-      m_controller.fetch<nfd::FaceQueryDataset>(
-        filter,
-        bind(&MobileTerminal::registerHubDiscoveryPrefix, this, _1),
-        [this] (uint32_t code, const std::string& reason) {
-          this->fail("Error " + to_string(code) + " when querying multi-access faces: " + reason);
-        });
+    [this, id] (const ControlParameters&) {
+      resume(id);
     },
-    [this] (const auto&...) {
-      this->fail("Cannot set FaceFlags bit");
+    [this, id] (const ControlResponse&) {
+      if (isCurrentSession(id)) {
+        this->fail("Cannot set FaceFlags bit");
+      }
     });
-
 }
 
 void
-MobileTerminal::waitUntilFibEntryHasNextHop(size_t nRetriesLeft,
-                                            const Name& prefix, uint64_t faceId,
-                                            const std::function<void()>& continueCallback)
+MobileTerminal::queryMultiAccessFaces()
 {
-  NDN_LOG_TRACE("Check if FIB entry " << prefix << " exists with nexthop " << faceId << ", retries left: " << nRetriesLeft);
-  m_controller.fetch<nfd::FibDataset>(
-    [=] (const std::vector<nfd::FibEntry>& result) {
-      bool hasDesiredNextHop = false;
-      for (const auto& entry : result) {
-        if (entry.getPrefix() == prefix) { // right now, there is no better way to query for a specifci FIB entry
-          for (const auto& nexthop : entry.getNextHopRecords()) {
-            if (nexthop.getFaceId() == faceId) {
-              hasDesiredNextHop = true;
-              break;
-            }
-          }
-          break;
-        }
+  uint64_t id = m_session->id;
+  nfd::FaceQueryFilter filter;
+  filter.setLinkType(nfd::LINK_TYPE_MULTI_ACCESS);
+
+  m_controller.fetch<nfd::FaceQueryDataset>(
+    filter,
+    [this, id] (const std::vector<nfd::FaceStatus>& dataset) {
+      if (!isCurrentSession(id)) {
+        return;
       }
-      if (!hasDesiredNextHop) {
-        if (nRetriesLeft > 0) {
-          m_wait = m_scheduler.schedule(100_ms, [=] {
-              waitUntilFibEntryHasNextHop(nRetriesLeft - 1, prefix, faceId, continueCallback);
-            });
+
+      std::vector<nfd::FaceStatus> faces;
+      for (const auto& faceStatus : dataset) {
+        if (m_interface.empty() || isOnInterface(faceStatus)) {
+          faces.push_back(faceStatus);
         }
       }
-      else {
-        continueCallback();
+      if (faces.empty()) {
+        this->fail(m_interface.empty() ? "No multi-access faces available" :
+                   "No multi-access faces available on " + m_interface);
+        return;
       }
+
+      if (m_networkFilter != nullptr) {
+        m_networkFilter->setMultiAccessFaces(faces);
+      }
+
+      m_session->multiAccessFaces.clear();
+      m_session->multiAccessFaces.reserve(faces.size());
+      for (const auto& faceStatus : faces) {
+        m_session->multiAccessFaces.push_back(faceStatus.getFaceId());
+      }
+
+      // faces of earlier networks are gone, and face IDs are not reused
+      const auto& current = m_session->multiAccessFaces;
+      for (auto it = m_faceRtt.begin(); it != m_faceRtt.end();) {
+        if (std::find(current.begin(), current.end(), it->first) == current.end()) {
+          it = m_faceRtt.erase(it);
+        }
+        else {
+          ++it;
+        }
+      }
+      m_session->nextFace = 0;
+      step();
     },
-    [=] (uint32_t code, const std::string& reason) {
-      NDN_LOG_ERROR("ERROR `" << reason << "` when checking for FIB entry for " << prefix << " prefix. Cannot proceed");
-      this->retval = -1;
-      this->errorInfo = "Error when registering " + prefix.toUri() + " prefix. Cannot proceed";
+    [this, id] (uint32_t code, const std::string& reason) {
+      if (isCurrentSession(id)) {
+        this->fail("Error " + to_string(code) + " when querying multi-access faces: " + reason);
+      }
     });
 }
 
+bool
+MobileTerminal::isOnInterface(const nfd::FaceStatus& face) const
+{
+  FaceUri uri;
+  if (!uri.parse(face.getLocalUri())) {
+    return false;
+  }
+  if (uri.getScheme() == "dev") {
+    return uri.getHost() == m_interface;
+  }
+  if (uri.getScheme() != "udp4" && uri.getScheme() != "udp") {
+    return false;
+  }
+
+  auto netif = m_networkMonitor != nullptr ? m_networkMonitor->getNetworkInterface(m_interface) : nullptr;
+  if (netif == nullptr) {
+    return false;
+  }
+  for (const auto& address : netif->getNetworkAddresses()) {
+    if (address.getIp().to_string() == uri.getHost()) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool
+hasNextHop(const std::vector<nfd::FibEntry>& fib, const Name& prefix, uint64_t faceId)
+{
+  for (const auto& entry : fib) {
+    if (entry.getPrefix() == prefix) { // right now, there is no better way to query for a specifci FIB entry
+      for (const auto& nexthop : entry.getNextHopRecords()) {
+        if (nexthop.getFaceId() == faceId) {
+          return true;
+        }
+      }
+      return false;
+    }
+  }
+  return false;
+}
 
 void
-MobileTerminal::registerPrefixAndEnsureFibEntry(const Name& prefix, uint64_t faceId,
-                                                const std::function<void()>& continueCallback)
+MobileTerminal::waitUntilFibEntryHasNextHop()
 {
-  // register CA prefix
-  ControlParameters parameters;
-  parameters.setName(prefix)
-    .setFaceId(faceId)
-    .setCost(ROUTE_COST)
-    .setExpirationPeriod(ROUTE_EXPIRATION);
+  uint64_t id = m_session->id;
+  ICEAR_BLOG_TRACE(CHECK_FIB_ENTRY, m_session->routePrefix, m_session->routeFaceId,
+                   m_session->nFibRetriesLeft);
+  icear::metrics::add(icear::metrics::Counter::FIB_POLLS);
 
-  m_controller.start<nfd::RibRegisterCommand>(
-    parameters,
-    [=] (const ControlParameters&) {
-      m_wait = m_scheduler.schedule(100_ms, [=] {
-          waitUntilFibEntryHasNextHop(50, prefix, faceId, continueCallback);
-        }); // wait up 5 seconds theen declare failure
+  m_controller.fetch<nfd::FibDataset>(
+    [this, id] (const std::vector<nfd::FibEntry>& result) {
+      if (!isCurrentSession(id)) {
+        return;
+      }
+      if (hasNextHop(result, m_session->routePrefix, m_session->routeFaceId)) {
+        step();
+      }
+      else if (m_session->nFibRetriesLeft > 0) {
+        --m_session->nFibRetriesLeft;
+        m_wait = m_timers.schedule(100_ms, FIB_POLL_SLACK, [this, id] {
+            if (isCurrentSession(id)) {
+              waitUntilFibEntryHasNextHop();
+            }
+          });
+      }
+      else {
+        this->fail("FIB entry for " + m_session->routePrefix.toUri() + " did not appear");
+      }
     },
-    [=] (const ControlResponse& resp) {
-      NDN_LOG_ERROR("ERROR `" << resp << "` when registering " << prefix << " prefix. Cannot proceed");
+    [this, id] (uint32_t code, const std::string& reason) {
+      if (!isCurrentSession(id)) {
+        return;
+      }
+      ICEAR_BLOG_ERROR(FIB_CHECK_ERROR, reason, m_session->routePrefix);
       this->retval = -1;
-      this->errorInfo = "Error when registering " + prefix.toUri() + " prefix. Cannot proceed";
+      this->errorInfo = "Error when registering " + m_session->routePrefix.toUri() + " prefix. Cannot proceed";
+      this->fail(this->errorInfo);
     });
 }
 
-
 void
-MobileTerminal::registerHubDiscoveryPrefix(const std::vector<nfd::FaceStatus>& dataset)
+MobileTerminal::registerPrefixAndEnsureFibEntry(const Name& prefix, uint64_t faceId)
 {
-  if (dataset.empty()) {
-    this->fail("No multi-access faces available");
-    return;
-  }
-
-  std::function<void()> callbackStack = [this] {
-    this->setStrategy();
-  };
+  uint64_t id = m_session->id;
+  m_session->routePrefix = prefix;
+  m_session->routeFaceId = faceId;
+  m_session->nFibRetriesLeft = 50; // wait up 5 seconds theen declare failure
 
-  for (const auto& faceStatus : dataset) {
-    auto stackHead = [this, callbackStack, faceStatus] {
-      this->registerPrefixAndEnsureFibEntry(HUB_DISCOVERY_PREFIX, faceStatus.getFaceId(), callbackStack);
-    };
-    callbackStack = stackHead;
-  }
-  callbackStack();
+  m_routes.registerRoute(prefix, faceId, id,
+    [this, id] (bool wasRegistered) {
+      if (!isCurrentSession(id)) {
+        return;
+      }
+      if (wasRegistered) {
+        // the route is already in RIB, so FIB has it as well
+        step();
+        return;
+      }
+      m_wait = m_timers.schedule(100_ms, FIB_POLL_SLACK, [this, id] {
+          if (isCurrentSession(id)) {
+            waitUntilFibEntryHasNextHop();
+          }
+        });
+    },
+    [this, id] (const std::string& reason) {
+      if (!isCurrentSession(id)) {
+        return;
+      }
+      ICEAR_BLOG_ERROR(REGISTER_ERROR, reason, m_session->routePrefix);
+      this->retval = -1;
+      this->errorInfo = "Error when registering " + m_session->routePrefix.toUri() + " prefix. Cannot proceed";
+      this->fail(this->errorInfo);
+    });
 }
 
 void
 MobileTerminal::setStrategy()
 {
+  uint64_t id = m_session->id;
   ControlParameters parameters;
   parameters.setName(HUB_DISCOVERY_PREFIX)
-            .setStrategy("/localhost/nfd/strategy/multicast"),
+            .setStrategy("/localhost/nfd/strategy/multicast");
 
   m_controller.start<nfd::StrategyChoiceSetCommand>(
     parameters,
-    [this] (const auto&...) {
-      requestHubData(3);
+    [this, id] (const ControlParameters&) {
+      resume(id);
     },
-    [this] (const ControlResponse& resp) {
-      this->fail("Error " + to_string(resp.getCode()) + " when setting multicast strategy: " +
-                 resp.getText());
+    [this, id] (const ControlResponse& resp) {
+      if (isCurrentSession(id)) {
+        this->fail("Error " + to_string(resp.getCode()) + " when setting multicast strategy: " +
+                   resp.getText());
+      }
     });
 }
 
+static uint64_t
+getIncomingFaceId(const Data& data)
+{
+  auto tag = data.getTag<lp::IncomingFaceIdTag>();
+  if (tag == nullptr) {
+    ICEAR_BLOG_ERROR(MISSING_INCOMING_FACE);
+    return 0;
+  }
+  return tag->get();
+}
+
 void
-MobileTerminal::requestHubData(size_t retriesLeft)
+MobileTerminal::requestHubData()
 {
+  uint64_t id = m_session->id;
+
   Interest interest(HUB_DISCOVERY_PREFIX);
-  interest.setInterestLifetime(HUB_DISCOVERY_INTEREST_LIFETIME);
+  interest.setInterestLifetime(getHubDiscoveryInterestLifetime());
   interest.setMustBeFresh(true);
   interest.setCanBePrefix(true);
 
-  NDN_LOG_WARN("Discover localhop CA via " << interest);
-
-  m_pi = m_face.expressInterest(interest,
-    [this] (const Interest&, const Data& data) {
-
-      const Block& content = data.getContent();
-      content.parse();
-      ndn::security::v2::Certificate cert(data.getContent().blockFromValue());
+  ICEAR_BLOG_WARN(DISCOVER_CA, interest.getName(), interest.getInterestLifetime());
+  icear::metrics::add(icear::metrics::Counter::DISCOVERY_ATTEMPTS);
 
-      // if (ndn::security::verifySignature(data, cert)){
-      //   std::cout << "Device certificate verified by trust anchor!!!\n";
-      // }
+  // Karn's algorithm: a Data after a timeout may answer any of the previous transmissions
+  bool isRetransmission = m_session->nDiscoveryRetriesLeft < HUB_DISCOVERY_RETRIES;
+  auto sentTime = time::steady_clock::now();
 
-      uint64_t faceId = 0;
-      auto tag = data.getTag<lp::IncomingFaceIdTag>();
-      if (tag != nullptr) {
-        faceId = tag->get();
-      }
-      else {
-        NDN_LOG_ERROR("Incoming data missing IncomingFaceIdTag");
+  m_pi = m_face.expressInterest(interest,
+    [this, id, isRetransmission, sentTime] (const Interest&, const Data& data) {
+      if (!isCurrentSession(id)) {
+        return;
       }
 
-      // Get CA namespace
-      Name caName = cert.getName().getPrefix(-4);
-
-      m_ndncertTool = std::make_unique<ndncert::LocationClientTool>(m_face, m_keyChain, caName, cert);
+      ndn::security::v2::Certificate cert;
+      if (!decodeDiscoveryData(data, cert)) {
+        if (m_session->nDiscoveryRetriesLeft > 0) {
+          --m_session->nDiscoveryRetriesLeft;
+          step();
+        }
+        else {
+          this->fail("Cannot discover local CA (no verifiable answers)");
+        }
+        return;
+      }
 
-      NDN_LOG_INFO("Discovered CA " << caName << "\nCA's certificate: " << cert);
+      uint64_t faceId = getIncomingFaceId(data);
+      if (!isRetransmission) {
+        getFaceRtt(faceId).addMeasurement(time::steady_clock::now() - sentTime);
+      }
 
-      // Get certificate to be used for signing data
-      registerPrefixAndRunNdncert(caName, faceId);
+      useDiscoveredCa(data, cert, faceId);
+      m_session->state = BootstrapState::REGISTER_CA_PREFIX;
+      step();
     },
-    [this, retriesLeft] (const Interest&, const lp::Nack& nack) {
-      if (retriesLeft > 0) {
-        NDN_LOG_DEBUG("   Got NACK (" << nack.getReason() << ". Retrying after 1 sec delay...");
+    [this, id] (const Interest&, const lp::Nack& nack) {
+      if (!isCurrentSession(id)) {
+        return;
+      }
+      icear::metrics::add(icear::metrics::Counter::DISCOVERY_NACKS);
+      if (m_session->nDiscoveryRetriesLeft > 0) {
+        --m_session->nDiscoveryRetriesLeft;
+        ICEAR_BLOG_DEBUG(DISCOVERY_NACK, nack.getReason());
 
-        m_wait = m_scheduler.schedule(1_s, [=] {
-            requestHubData(retriesLeft - 1);
+        m_wait = m_timers.schedule(1_s, DISCOVERY_BACKOFF_SLACK, [this, id] {
+            resume(id);
           });
       }
       else {
         this->fail("Cannot discover local CA (NACKs)");
       }
     },
-    [this, retriesLeft] (const Interest&) {
-      if (retriesLeft > 0) {
-        NDN_LOG_DEBUG("   Got timeout. Retrying...");
-        requestHubData(retriesLeft - 1);
+    [this, id] (const Interest&) {
+      if (!isCurrentSession(id)) {
+        return;
+      }
+      icear::metrics::add(icear::metrics::Counter::DISCOVERY_TIMEOUTS);
+      if (m_session->nDiscoveryRetriesLeft > 0) {
+        --m_session->nDiscoveryRetriesLeft;
+        for (uint64_t faceId : m_session->multiAccessFaces) {
+          getFaceRtt(faceId).backoffRto();
+        }
+        ICEAR_BLOG_DEBUG(DISCOVERY_TIMEOUT, getHubDiscoveryInterestLifetime());
+        step();
       }
       else {
         this->fail("Cannot discover local CA (timed out)");
@@ -262,67 +580,577 @@ MobileTerminal::requestHubData(size_t retriesLeft)
     });
 }
 
-void
-MobileTerminal::fail(const std::string& msg)
+bool
+MobileTerminal::requestCachedCa()
 {
-  NDN_LOG_ERROR("ERROR: " << msg);
+  if (m_session->network.empty()) {
+    return false;
+  }
+  const CaLocation* location = m_caLocations.find(m_session->network);
+  if (location == nullptr) {
+    return false;
+  }
 
-  m_wait = m_scheduler.schedule(60_s, [this] {
-      NDN_LOG_INFO("Delayed re-run of NDNCERT (complete)");
+  const auto& faces = m_session->multiAccessFaces;
+  if (std::find(faces.begin(), faces.end(), location->faceId) == faces.end()) {
+    // e.g., NFD re-created the face for a new address of the interface
+    forgetCachedCa(location->caName, "face " + to_string(location->faceId) + " is gone");
+    return false;
+  }
 
-      m_face.shutdown(); // hopefully, this will stop the process so we ready to re-run...
-      runDiscoveryAndNdncert();
+  uint64_t id = m_session->id;
+  Name caName = location->caName;
+  security::v2::Certificate pinnedCert = location->cert;
+  uint64_t faceId = location->faceId;
+
+  // NextHopFaceId takes the Interest straight to the face, so neither the discovery prefix
+  // registrations nor the multicast strategy are needed
+  Name discoveryName(HUB_DISCOVERY_PREFIX);
+  if (location->discoveryComponent.value_size() > 0) {
+    discoveryName.append(location->discoveryComponent); // only this CA's Data can answer
+  }
+  Interest interest(discoveryName);
+  const RttEstimator& rtt = getFaceRtt(faceId);
+  if (rtt.hasSamples()) {
+    interest.setInterestLifetime(rtt.getInterestLifetime());
+  }
+  else if (location->rtt > time::nanoseconds::zero()) {
+    interest.setInterestLifetime(std::min(std::max(time::duration_cast<time::milliseconds>(4 * location->rtt),
+                                                   CACHED_CA_MIN_INTEREST_LIFETIME),
+                                          HUB_DISCOVERY_INTEREST_LIFETIME));
+  }
+  else {
+    interest.setInterestLifetime(HUB_DISCOVERY_INTEREST_LIFETIME);
+  }
+  interest.setMustBeFresh(true);
+  interest.setCanBePrefix(true);
+  interest.setTag(make_shared<lp::NextHopFaceIdTag>(faceId));
+
+  ICEAR_BLOG_INFO(DISCOVER_CACHED_CA, caName, interest.getName(), faceId, interest.getInterestLifetime());
+  icear::metrics::add(icear::metrics::Counter::DISCOVERY_ATTEMPTS);
+  auto sentTime = time::steady_clock::now();
+
+  m_pi = m_face.expressInterest(interest,
+    [this, id, caName, pinnedCert, faceId, sentTime] (const Interest&, const Data& data) {
+      if (!isCurrentSession(id)) {
+        return;
+      }
+
+      ndn::security::v2::Certificate cert;
+      if (!decodeDiscoveryData(data, cert)) {
+        forgetCachedCa(caName, "discovery Data cannot be verified");
+        step();
+        return;
+      }
+      // a self-signed certificate proves nothing about who answers; only the CA found on this
+      // network before, with the same key, is trusted without a new discovery
+      if (cert.getKeyName() != pinnedCert.getKeyName() ||
+          cert.getPublicKey() != pinnedCert.getPublicKey()) {
+        forgetCachedCa(caName, "answered with the key of " + cert.getKeyName().toUri());
+        step();
+        return;
+      }
+
+      getFaceRtt(faceId).addMeasurement(time::steady_clock::now() - sentTime);
+      icear::metrics::add(icear::metrics::Counter::CA_CACHE_HITS);
+      useDiscoveredCa(data, cert, faceId);
+      m_session->state = BootstrapState::REGISTER_CA_PREFIX;
+      step();
+    },
+    [this, id, caName] (const Interest&, const lp::Nack& nack) {
+      if (!isCurrentSession(id)) {
+        return;
+      }
+      icear::metrics::add(icear::metrics::Counter::DISCOVERY_NACKS);
+      ICEAR_BLOG_DEBUG(DISCOVERY_NACK, nack.getReason());
+      forgetCachedCa(caName, "NACK");
+      step();
+    },
+    [this, id, caName, faceId] (const Interest&) {
+      if (!isCurrentSession(id)) {
+        return;
+      }
+      icear::metrics::add(icear::metrics::Counter::DISCOVERY_TIMEOUTS);
+      getFaceRtt(faceId).backoffRto();
+      forgetCachedCa(caName, "timed out");
+      step();
     });
+  return true;
 }
 
 void
-MobileTerminal::registerPrefixAndRunNdncert(const Name& caPrefix, uint64_t faceId)
+MobileTerminal::forgetCachedCa(const Name& caName, const std::string& reason)
 {
-  NDN_LOG_WARN("Requesting certificate from CA " << caPrefix);
+  ICEAR_BLOG_INFO(CA_CACHE_MISS, caName, reason);
+  icear::metrics::add(icear::metrics::Counter::CA_CACHE_MISSES);
+  m_caLocations.erase(m_session->network);
+}
 
-  // // register CA prefix
-  registerPrefixAndEnsureFibEntry(caPrefix, faceId, [this, faceId] {
-      registerPrefixAndEnsureFibEntry("/localhop/CA", faceId, [this] {
-          runNdncert();
-        });
+void
+MobileTerminal::useDiscoveredCa(const Data& data, const security::v2::Certificate& cert,
+                                uint64_t faceId)
+{
+  // Get CA namespace
+  Name caName = cert.getName().getPrefix(-4);
+
+  m_ndncertTool = std::make_unique<ndncert::LocationClientTool>(m_face, m_keyChain, caName, cert,
+                                                                m_caContexts[caName], m_verifiers, m_arena);
+
+  ICEAR_BLOG_INFO(DISCOVERED_CA, caName, cert);
+
+  // Get certificate to be used for signing data
+  m_session->caName = caName;
+  m_session->caFaceId = faceId;
+  if (data.getName().size() > HUB_DISCOVERY_PREFIX.size()) {
+    m_session->caDiscoveryComponent = data.getName().get(HUB_DISCOVERY_PREFIX.size());
+  }
+
+  if (m_session->network.empty() || faceId == 0) {
+    return;
+  }
+  CaLocation location;
+  location.caName = caName;
+  location.cert = cert;
+  location.faceId = faceId;
+  location.discoveryComponent = m_session->caDiscoveryComponent;
+  const RttEstimator& rtt = getFaceRtt(faceId);
+  if (rtt.hasSamples()) {
+    location.rtt = rtt.getSmoothedRtt();
+  }
+  m_caLocations.insert(m_session->network, location);
+}
+
+bool
+MobileTerminal::decodeDiscoveryData(const Data& data, security::v2::Certificate& cert)
+{
+  try {
+    const Block& content = data.getContent();
+    content.parse();
+    cert = security::v2::Certificate(content.blockFromValue());
+  }
+  catch (const tlv::Error& e) {
+    ICEAR_BLOG_ERROR(DISCOVERY_BAD_CERT, data.getName(), e.what());
+    return false;
+  }
+
+  // there is no trust anchor for the CA of a network we have not been to yet, so the certificate
+  // can only be checked for being a well-formed, currently valid CA self-signed certificate
+  if (cert.getSignature().getKeyLocator().getType() != tlv::Name ||
+      cert.getSignature().getKeyLocator().getName() != cert.getKeyName()) {
+    ICEAR_BLOG_ERROR(DISCOVERY_BAD_CERT, data.getName(), "not self-signed");
+    return false;
+  }
+  if (!cert.isValid()) {
+    ICEAR_BLOG_ERROR(DISCOVERY_BAD_CERT, data.getName(), "outside of validity period");
+    return false;
+  }
+  if (!m_verifiers.verify(cert, cert)) {
+    ICEAR_BLOG_ERROR(DISCOVERY_BAD_CERT, data.getName(), "bad self-signature");
+    return false;
+  }
+
+  if (!m_verifiers.verify(data, cert)) {
+    ICEAR_BLOG_ERROR(DISCOVERY_BAD_SIGNATURE, data.getName());
+    return false;
+  }
+  return true;
+}
+
+RttEstimator&
+MobileTerminal::getFaceRtt(uint64_t faceId)
+{
+  auto it = m_faceRtt.find(faceId);
+  if (it == m_faceRtt.end()) {
+    auto options = RttEstimator::getDefaultOptions();
+    options.initialRto = HUB_DISCOVERY_INTEREST_LIFETIME;
+    it = m_faceRtt.emplace(faceId, RttEstimator(options)).first;
+  }
+  return it->second;
+}
+
+time::milliseconds
+MobileTerminal::getHubDiscoveryInterestLifetime() const
+{
+  // discovery is multicast on the session's multi-access faces, so wait for the slowest of them
+  time::milliseconds lifetime = 0_ms;
+  for (uint64_t faceId : m_session->multiAccessFaces) {
+    auto rtt = m_faceRtt.find(faceId);
+    if (rtt != m_faceRtt.end() && rtt->second.hasSamples()) {
+      lifetime = std::max(lifetime, rtt->second.getInterestLifetime());
+    }
+  }
+  return lifetime > 0_ms ? lifetime : HUB_DISCOVERY_INTEREST_LIFETIME;
+}
+
+void
+MobileTerminal::fail(const std::string& msg)
+{
+  ICEAR_BLOG_ERROR(GENERIC_ERROR, msg);
+
+  m_wait = m_timers.schedule(60_s, RERUN_SLACK, [this] {
+      ICEAR_BLOG_INFO(RERUN_COMPLETE);
+      runDiscoveryAndNdncert();
     });
 }
 
+static std::string
+makeRandomUserIdentity()
+{
+  const std::string letters = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ01234567890";
+  std::string identity;
+  std::generate_n(std::back_inserter(identity), 10,
+                  [&letters] () -> char {
+                    return letters[random::generateSecureWord32() % letters.size()];
+                  });
+  return identity;
+}
+
 void
 MobileTerminal::runNdncert()
 {
+  uint64_t id = m_session->id;
   try {
-    const std::string letters = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ01234567890";
-    std::string randomUserIdentity;
-    std::generate_n(std::back_inserter(randomUserIdentity), 10,
-                    [&letters] () -> char {
-                      return letters[random::generateSecureWord32() % letters.size()];
-                    });
+    m_session->userIdentity = makeRandomUserIdentity();
 
     BOOST_ASSERT(m_ndncertTool != nullptr);
 
-    m_onSuccessConnection = m_ndncertTool->onSuccess.connect([this] (const Certificate& cert) {
-        m_gotCert = true;
+    m_onSuccessConnection = m_ndncertTool->onSuccess.connect([this, id] (const Certificate&) {
+        if (!isCurrentSession(id)) {
+          return;
+        }
+        onNdncertStep(m_primaryClock, LocationClientTool::Step::DONE);
+        onCertificateIssued(false);
       });
-    m_onFailConnection = m_ndncertTool->onFailure.connect([this, randomUserIdentity] (const auto&...) {
+    m_onFailConnection = m_ndncertTool->onFailure.connect([this, id] (const std::string&) {
+        if (!isCurrentSession(id)) {
+          return;
+        }
         // a bit redundant
         m_gotCert = false;
+        m_stepDeadline.cancel();
 
-        // try again in 60 seconds
-        m_wait = m_scheduler.schedule(60_s, [=] {
-            NDN_LOG_INFO("Delayed re-run on NDNCERT (cert only)");
-            m_ndncertTool->start(randomUserIdentity);
-          });
+        if (isHedgeRunning()) {
+          return; // the hedged request may still get the certificate
+        }
+        scheduleNdncertRetry();
       });
 
-    m_ndncertTool->start(randomUserIdentity);
+    if (m_isHedgingEnabled) {
+      m_ndncertTool->setLocalhopFaceId(m_session->caFaceId);
+      m_onStepConnection = m_ndncertTool->onStepStarted.connect([this, id] (LocationClientTool::Step step) {
+          if (!isCurrentSession(id)) {
+            return;
+          }
+          onNdncertStep(m_primaryClock, step);
+          armStepDeadline(step);
+        });
+    }
+
+    m_ndncertTool->start(m_session->userIdentity);
   }
   catch (const std::exception& error) {
-    NDN_LOG_ERROR(boost::diagnostic_information(error));
+    ICEAR_BLOG_ERROR(EXCEPTION, boost::diagnostic_information(error));
     this->retval = -1;
     this->errorInfo = error.what();
   }
 }
 
+void
+MobileTerminal::scheduleNdncertRetry()
+{
+  uint64_t id = m_session->id;
+
+  // try again in 60 seconds
+  m_wait = m_timers.schedule(60_s, RERUN_SLACK, [this, id] {
+      if (!isCurrentSession(id)) {
+        return;
+      }
+      ICEAR_BLOG_INFO(RERUN_CERT_ONLY);
+      m_ndncertTool->start(m_session->userIdentity);
+    });
+}
+
+void
+MobileTerminal::onNdncertStep(StepClock& clock, LocationClientTool::Step step)
+{
+  auto now = time::steady_clock::now();
+  // a restart (PROBE) follows a failed request, whose last step did not complete
+  if (clock.step != LocationClientTool::Step::IDLE && clock.step != LocationClientTool::Step::DONE &&
+      step != LocationClientTool::Step::PROBE) {
+    m_stepLatency[clock.step].addSample(now - clock.start);
+  }
+  clock.step = step;
+  clock.start = now;
+}
+
+time::nanoseconds
+MobileTerminal::getStepDeadline(LocationClientTool::Step step) const
+{
+  auto latency = m_stepLatency.find(step);
+  if (latency == m_stepLatency.end() || latency->second.size() < HEDGE_MIN_SAMPLES) {
+    return HEDGE_DEFAULT_STEP_DEADLINE;
+  }
+  return std::max<time::nanoseconds>(latency->second.getPercentile(HEDGE_PERCENTILE), HEDGE_MIN_STEP_DEADLINE);
+}
+
+void
+MobileTerminal::armStepDeadline(LocationClientTool::Step step)
+{
+  if (m_session->isHedgeStarted || step == LocationClientTool::Step::IDLE ||
+      step == LocationClientTool::Step::DONE) {
+    m_stepDeadline.cancel();
+    return;
+  }
+
+  uint64_t id = m_session->id;
+  auto deadline = getStepDeadline(step);
+  m_stepDeadline = m_timers.schedule(deadline, deadline / 10, [this, id, step, deadline] {
+      if (!isCurrentSession(id) || m_session->isHedgeStarted ||
+          m_session->state == BootstrapState::DONE) {
+        return;
+      }
+      ICEAR_BLOG_INFO(HEDGE_START, static_cast<int>(step), m_session->caName,
+                      time::duration_cast<time::milliseconds>(deadline));
+      startHedge();
+    });
+}
+
+void
+MobileTerminal::onCertificateIssued(bool isHedge)
+{
+  if (m_session->state == BootstrapState::DONE) {
+    return; // the other request has already won
+  }
+
+  m_gotCert = true;
+  m_session->state = BootstrapState::DONE;
+  icear::metrics::set(icear::metrics::Gauge::BOOTSTRAP_STATE, static_cast<int64_t>(m_session->state));
+  icear::metrics::add(icear::metrics::Counter::CERTIFICATES_ISSUED);
+  icear::metrics::record(icear::metrics::Histogram::ISSUANCE_LATENCY,
+                         time::steady_clock::now() - m_session->startTime);
+  m_stepDeadline.cancel();
+  m_wait.cancel();
+
+  if (m_hedge == nullptr) {
+    return;
+  }
+
+  m_hedgePi.cancel();
+  ICEAR_BLOG_INFO(ISSUANCE_WINNER, isHedge ? m_hedge->caName : m_session->caName,
+                  std::string(isHedge ? "hedged" : "primary"));
+  // the loser's tool stays around, idle, until the session ends, while its routes lapse
+  if (isHedge) {
+    m_ndncertTool->cancel();
+    releaseCaRoutes(m_session->caName, m_session->caFaceId, m_hedge->caFaceId);
+  }
+  else if (m_hedge->tool != nullptr) {
+    m_hedge->tool->cancel();
+    releaseCaRoutes(m_hedge->caName, m_hedge->caFaceId, m_session->caFaceId);
+  }
+  m_hedge->isActive = false;
+}
+
+void
+MobileTerminal::releaseCaRoutes(const Name& caName, uint64_t faceId, uint64_t otherCaFaceId)
+{
+  m_routes.releaseRoute(caName, faceId);
+  if (faceId != otherCaFaceId) {
+    m_routes.releaseRoute("/localhop/CA", faceId);
+  }
+}
+
+void
+MobileTerminal::startHedge()
+{
+  m_session->isHedgeStarted = true;
+  m_hedge = std::make_unique<Hedge>();
+
+  if (m_session->caDiscoveryComponent.empty()) {
+    abandonHedge("discovery Data of " + m_session->caName.toUri() + " cannot be excluded");
+    return;
+  }
+
+  // ask again, this time excluding the answer of the CA already in use
+  Interest interest(HUB_DISCOVERY_PREFIX);
+  interest.setInterestLifetime(getHubDiscoveryInterestLifetime());
+  interest.setMustBeFresh(true);
+  interest.setCanBePrefix(true);
+  Exclude exclude;
+  exclude.excludeOne(m_session->caDiscoveryComponent);
+  interest.setExclude(exclude);
+
+  ICEAR_BLOG_WARN(DISCOVER_CA, interest.getName(), interest.getInterestLifetime());
+  icear::metrics::add(icear::metrics::Counter::DISCOVERY_ATTEMPTS);
+
+  uint64_t id = m_session->id;
+  m_hedgePi = m_face.expressInterest(interest,
+    [this, id] (const Interest&, const Data& data) {
+      if (!isCurrentSession(id) || !isHedgeRunning()) {
+        return;
+      }
+
+      ndn::security::v2::Certificate cert;
+      if (!decodeDiscoveryData(data, cert)) {
+        abandonHedge("alternate CA's discovery Data cannot be verified");
+        return;
+      }
+
+      Name caName = cert.getName().getPrefix(-4);
+      if (caName == m_session->caName) {
+        abandonHedge("only " + caName.toUri() + " answered");
+        return;
+      }
+
+      m_hedge->caName = caName;
+      m_hedge->caFaceId = getIncomingFaceId(data);
+      m_hedge->tool = std::make_unique<LocationClientTool>(m_face, m_keyChain, caName, cert,
+                                                           m_caContexts[caName], m_verifiers, m_arena);
+      ICEAR_BLOG_INFO(DISCOVERED_CA, caName, cert);
+
+      // same routes as for the primary CA
+      registerHedgeRoute(caName, [this] {
+          if (m_hedge->caFaceId == m_session->caFaceId) {
+            runHedgedNdncert();
+            return;
+          }
+          registerHedgeRoute("/localhop/CA", [this] {
+              runHedgedNdncert();
+            });
+        });
+    },
+    [this, id] (const Interest&, const lp::Nack& nack) {
+      if (isCurrentSession(id) && isHedgeRunning()) {
+        icear::metrics::add(icear::metrics::Counter::DISCOVERY_NACKS);
+        ICEAR_BLOG_DEBUG(DISCOVERY_NACK, nack.getReason());
+        abandonHedge("no alternate CA (NACK)");
+      }
+    },
+    [this, id] (const Interest&) {
+      if (isCurrentSession(id) && isHedgeRunning()) {
+        icear::metrics::add(icear::metrics::Counter::DISCOVERY_TIMEOUTS);
+        abandonHedge("no alternate CA (timed out)");
+      }
+    });
+}
+
+void
+MobileTerminal::registerHedgeRoute(const Name& prefix, const std::function<void()>& then)
+{
+  uint64_t id = m_session->id;
+  uint64_t faceId = m_hedge->caFaceId;
+  m_routes.registerRoute(prefix, faceId, id,
+    [this, id, prefix, faceId, then] (bool wasRegistered) {
+      if (!isCurrentSession(id)) {
+        return;
+      }
+      if (!isHedgeRunning()) {
+        m_routes.releaseRoute(prefix, faceId); // registered after the hedge was over
+        return;
+      }
+      if (wasRegistered) {
+        then();
+        return;
+      }
+      m_hedge->wait = m_timers.schedule(100_ms, FIB_POLL_SLACK, [this, id, prefix, then] {
+          if (isCurrentSession(id) && isHedgeRunning()) {
+            waitUntilHedgeFibEntryHasNextHop(prefix, 50, then);
+          }
+        });
+    },
+    [this, id, prefix] (const std::string& reason) {
+      if (isCurrentSession(id) && isHedgeRunning()) {
+        abandonHedge("cannot register " + prefix.toUri() + ": " + reason);
+      }
+    });
+}
+
+void
+MobileTerminal::waitUntilHedgeFibEntryHasNextHop(const Name& prefix, size_t nRetriesLeft,
+                                                 const std::function<void()>& then)
+{
+  uint64_t id = m_session->id;
+  ICEAR_BLOG_TRACE(CHECK_FIB_ENTRY, prefix, m_hedge->caFaceId, nRetriesLeft);
+  icear::metrics::add(icear::metrics::Counter::FIB_POLLS);
+
+  m_controller.fetch<nfd::FibDataset>(
+    [this, id, prefix, nRetriesLeft, then] (const std::vector<nfd::FibEntry>& result) {
+      if (!isCurrentSession(id) || !isHedgeRunning()) {
+        return;
+      }
+      if (hasNextHop(result, prefix, m_hedge->caFaceId)) {
+        then();
+      }
+      else if (nRetriesLeft > 0) {
+        m_hedge->wait = m_timers.schedule(100_ms, FIB_POLL_SLACK, [this, id, prefix, nRetriesLeft, then] {
+            if (isCurrentSession(id) && isHedgeRunning()) {
+              waitUntilHedgeFibEntryHasNextHop(prefix, nRetriesLeft - 1, then);
+            }
+          });
+      }
+      else {
+        abandonHedge("FIB entry for " + prefix.toUri() + " did not appear");
+      }
+    },
+    [this, id, prefix] (uint32_t code, const std::string& reason) {
+      if (isCurrentSession(id) && isHedgeRunning()) {
+        ICEAR_BLOG_ERROR(FIB_CHECK_ERROR, reason, prefix);
+        abandonHedge("cannot check FIB entry for " + prefix.toUri());
+      }
+    });
+}
+
+void
+MobileTerminal::runHedgedNdncert()
+{
+  uint64_t id = m_session->id;
+  LocationClientTool& tool = *m_hedge->tool;
+  ICEAR_BLOG_WARN(REQUEST_CERT_FROM_CA, m_hedge->caName);
+
+  m_hedge->onSuccessConnection = tool.onSuccess.connect([this, id] (const Certificate&) {
+      if (isCurrentSession(id) && isHedgeRunning()) {
+        onNdncertStep(m_hedge->clock, LocationClientTool::Step::DONE);
+        onCertificateIssued(true);
+      }
+    });
+  m_hedge->onFailureConnection = tool.onFailure.connect([this, id] (const std::string& reason) {
+      if (isCurrentSession(id) && isHedgeRunning()) {
+        abandonHedge(reason);
+      }
+    });
+  m_hedge->onStepConnection = tool.onStepStarted.connect([this, id] (LocationClientTool::Step step) {
+      if (isCurrentSession(id) && m_hedge != nullptr) {
+        onNdncertStep(m_hedge->clock, step);
+      }
+    });
+
+  tool.setLocalhopFaceId(m_hedge->caFaceId);
+  try {
+    m_hedge->userIdentity = makeRandomUserIdentity();
+    tool.start(m_hedge->userIdentity);
+  }
+  catch (const std::exception& error) {
+    abandonHedge(boost::diagnostic_information(error));
+  }
+}
+
+void
+MobileTerminal::abandonHedge(const std::string& reason)
+{
+  ICEAR_BLOG_DEBUG(HEDGE_ABANDONED, reason);
+  m_hedge->isActive = false;
+  m_hedgePi.cancel();
+  m_hedge->wait.cancel();
+  if (m_hedge->tool != nullptr) {
+    m_hedge->tool->cancel();
+    releaseCaRoutes(m_hedge->caName, m_hedge->caFaceId, m_session->caFaceId);
+  }
+
+  // the primary request failed while the hedge was running, and left the retry to it
+  if (m_session->state != BootstrapState::DONE && m_ndncertTool != nullptr &&
+      m_ndncertTool->getStep() == LocationClientTool::Step::IDLE) {
+    scheduleNdncertRetry();
+  }
+}
+
 } // namespace ndncert
 } // namespace ndn
@@ -5,70 +5,380 @@
 
 #include <ndn-cxx/face.hpp>
 #include <ndn-cxx/mgmt/nfd/controller.hpp>
+#include <ndn-cxx/mgmt/nfd/fib-entry.hpp>
 #include <ndn-cxx/mgmt/nfd/face-status.hpp>
 #include <ndn-cxx/net/face-uri.hpp>
 #include <ndn-cxx/net/network-monitor.hpp>
 
+#include "latency-window.hpp"
 #include "location-client-tool.hpp"
+#include "ca-location-cache.hpp"
+#include "loop-monitor.hpp"
+#include "network-change-filter.hpp"
+#include "route-lease-manager.hpp"
+#include "rtt-estimator.hpp"
+#include "session-arena.hpp"
+#include "timer-wheel.hpp"
+
+#include <atomic>
+#include <mutex>
 
 namespace ndn {
 namespace ndncert {
 
+/**
+ * @brief Check whether FIB dataset @p fib has entry for @p prefix with nexthop @p faceId
+ */
+bool
+hasNextHop(const std::vector<nfd::FibEntry>& fib, const Name& prefix, uint64_t faceId);
+
 class MobileTerminal
 {
 public:
-  MobileTerminal(KeyChain& keyChain, const std::function<bool()>& filterNetworkChange);
+  /**
+   * @param transport transport to the forwarder; the default transport is used if nullptr
+   */
+  MobileTerminal(KeyChain& keyChain, const std::function<bool()>& filterNetworkChange,
+                 shared_ptr<Transport> transport = nullptr);
 
   // will block until doStop
   void
   doStart();
 
+  /**
+   * @brief Stop; must be called on the I/O thread, use stop() from other threads
+   */
   void
   doStop();
 
+  /**
+   * @brief Stop from any thread; returns immediately
+   *
+   * doStop() is posted to the I/O thread, and doStart() returns once the routes are withdrawn or
+   * their withdrawal times out (1 s), whichever comes first.  Further calls have no effect.
+   */
+  void
+  stop();
+
+  /**
+   * @brief Run the bootstrap again from any thread, keeping the face, routes and CA state
+   *
+   * This is the fast path for service restarts: keys, route leases, verified CA certificates and
+   * RTT estimates all carry over to the new bootstrap.  Pending Interests of the old bootstrap
+   * are dropped (Face::shutdown); the new bootstrap checks the route leases against the RIB and
+   * takes over those it registers again, while the others lapse.
+   */
+  void
+  restart(bool isHedgingEnabled);
+
+  bool
+  isStopping() const
+  {
+    return m_isStopping;
+  }
+
+  /**
+   * @brief Arena statistics of the last finished (cancelled or replaced) bootstrap session; can
+   *        be called from any thread
+   */
+  SessionArena::Stats
+  getLastSessionArenaStats() const
+  {
+    std::lock_guard<std::mutex> lock(m_arenaStatsMutex);
+    return m_lastSessionArenaStats;
+  }
+
+  const TimerWheel::Stats&
+  getTimerStats() const
+  {
+    return m_timers.getStats();
+  }
+
+  /**
+   * @brief Lag and stall statistics of the I/O loop; can be called from any thread
+   */
+  LoopMonitor::Stats
+  getLoopStats() const
+  {
+    return m_loopMonitor.getStats();
+  }
+
+  /**
+   * @brief Hedge NDNCERT issuance with a second CA when a step runs late
+   *
+   * When a step of the request to the discovered CA takes longer than the 90th percentile of
+   * previous durations of that step, another CA is discovered and a second request is run against
+   * it.  The first certificate issued wins and the other request is cancelled.
+   */
+  void
+  setHedgedIssuance(bool isEnabled)
+  {
+    m_isHedgingEnabled = isEnabled;
+  }
+
+  /**
+   * @brief Capture the I/O thread's stack when the loop stalls (installs a SIGURG handler);
+   *        must be called before doStart()
+   */
+  void
+  setStallStackCapture(bool isEnabled)
+  {
+    m_loopMonitor.setStackCaptureEnabled(isEnabled);
+  }
+
+  /**
+   * @brief Set identifier of the network (e.g., BSSID of the access point) the next bootstrap
+   *        runs on; must be called on the I/O thread or before doStart()
+   *
+   * The CA discovered on a network is cached under its identifier, and a bootstrap on a known
+   * network first asks the cached CA directly, over the face it was found on.  Only if that CA
+   * does not answer, the discovery Interest is multicast on all multi-access faces.  An empty
+   * identifier (unknown network) always takes multicast discovery.
+   */
+  void
+  setNetwork(const std::string& network)
+  {
+    m_network = network;
+  }
+
+  /**
+   * @brief Bootstrap only on multi-access faces of network interface @p interface (all faces if
+   *        empty); must be called before doStart()
+   *
+   * A face is on the interface if its local URI is `dev://<interface>`, or `udp4://<address>:<port>`
+   * with an address of the interface.  Addresses come from the network monitor, so the first
+   * bootstrap waits for its enumeration.
+   */
+  void
+  setInterface(const std::string& interface)
+  {
+    m_interface = interface;
+  }
+
+  const CaLocationCache::Stats&
+  getCaLocationStats() const
+  {
+    return m_caLocations.getStats();
+  }
+
 private:
+  /**
+   * @brief Steps of the bootstrap state machine
+   *
+   * Each asynchronous operation is issued with the session state already set to the step that
+   * follows it, and its completion calls resume() with the session ID it was started for.
+   */
+  enum class BootstrapState {
+    ENABLE_LOCAL_FIELDS,
+    SYNC_ROUTES,
+    QUERY_FACES,
+    REGISTER_DISCOVERY_PREFIX,
+    SET_STRATEGY,
+    DISCOVER_CA,
+    REGISTER_CA_PREFIX,
+    REGISTER_LOCALHOP_CA_PREFIX,
+    NDNCERT,
+    DONE,
+    // values are reported in the BOOTSTRAP_STATE gauge, so new steps go last, whatever their order
+    DISCOVER_CACHED_CA // between QUERY_FACES and REGISTER_DISCOVERY_PREFIX
+  };
+
+  /**
+   * @brief All state of one runDiscoveryAndNdncert() run
+   *
+   * Created in (and together with its containers drawing from) the session arena; callbacks
+   * capture only `this` and the session ID, so releasing the arena is all that is needed to
+   * cancel everything that is still in flight.
+   */
+  struct Session
+  {
+    explicit
+    Session(SessionArena& arena)
+      : multiAccessFaces(ArenaAllocator<uint64_t>(arena))
+    {
+    }
+
+    uint64_t id = 0;
+    BootstrapState state = BootstrapState::ENABLE_LOCAL_FIELDS;
+    time::steady_clock::TimePoint startTime;
+    std::string network; ///< key in the CA location cache, empty if unknown
+
+    std::vector<uint64_t, ArenaAllocator<uint64_t>> multiAccessFaces;
+    size_t nextFace = 0;
+
+    // target of the registration in progress
+    Name routePrefix;
+    uint64_t routeFaceId = 0;
+    size_t nFibRetriesLeft = 0;
+
+    size_t nDiscoveryRetriesLeft = 0;
+
+    Name caName;
+    uint64_t caFaceId = 0;
+    name::Component caDiscoveryComponent; ///< distinguishes the CA's discovery Data
+    std::string userIdentity;
+
+    bool isHedgeStarted = false;
+  };
+
+  /**
+   * @brief Timing of the current step of one NDNCERT request
+   */
+  struct StepClock
+  {
+    LocationClientTool::Step step = LocationClientTool::Step::IDLE;
+    time::steady_clock::TimePoint start;
+  };
+
+  /**
+   * @brief Second NDNCERT request, against an alternate CA (hedged issuance)
+   *
+   * The tool is kept until the session ends even if it loses or fails, as ClientModule callbacks
+   * may only be dropped together with the Face's pending Interests.
+   */
+  struct Hedge
+  {
+    Name caName;
+    uint64_t caFaceId = 0;
+    std::string userIdentity;
+    bool isActive = true;
+    StepClock clock;
+    TimerWheel::ScopedTimerId wait;
+
+    std::unique_ptr<LocationClientTool> tool;
+    util::signal::ScopedConnection onSuccessConnection;
+    util::signal::ScopedConnection onFailureConnection;
+    util::signal::ScopedConnection onStepConnection;
+  };
+
   void
   runDiscoveryAndNdncert();
 
   void
-  waitUntilFibEntryHasNextHop(size_t nRetriesLeft,
-                              const Name& prefix, uint64_t faceId,
-                              const std::function<void()>& continueCallback);
+  cancelSession();
+
+  bool
+  isCurrentSession(uint64_t sessionId) const
+  {
+    return m_session != nullptr && m_session->id == sessionId;
+  }
+
+  void
+  resume(uint64_t sessionId);
 
   void
-  registerPrefixAndEnsureFibEntry(const Name& prefix, uint64_t faceId,
-                                  const std::function<void()>& continueCallback);
+  step();
 
   void
-  registerHubDiscoveryPrefix(const std::vector<nfd::FaceStatus>& dataset);
+  enableLocalFields();
+
+  void
+  queryMultiAccessFaces();
+
+  bool
+  isOnInterface(const nfd::FaceStatus& face) const;
 
   void
   setStrategy();
 
   void
-  onInterest(const InterestFilter& filter, const Interest& interest);
+  registerPrefixAndEnsureFibEntry(const Name& prefix, uint64_t faceId);
 
   void
-  startListener();
+  waitUntilFibEntryHasNextHop();
 
   void
-  onRegisterFailed(const Name& prefix, const std::string& reason);
+  requestHubData();
+
+  /**
+   * @brief Ask the CA cached for the session's network directly over its face
+   * @return false if there is no usable cache entry
+   */
+  bool
+  requestCachedCa();
 
+  /**
+   * @brief Drop the cache entry of the session's network, whose CA @p caName is not usable
+   */
   void
-  requestHubData(size_t nRetriesLeft);
+  forgetCachedCa(const Name& caName, const std::string& reason);
 
+  /**
+   * @brief Use the CA whose discovery Data came verified from @p faceId, and cache its location
+   */
   void
-  fail(const std::string& msg);
+  useDiscoveredCa(const Data& data, const security::v2::Certificate& cert, uint64_t faceId);
+
+  RttEstimator&
+  getFaceRtt(uint64_t faceId);
+
+  time::milliseconds
+  getHubDiscoveryInterestLifetime() const;
 
   void
-  registerPrefixAndRunNdncert(const Name& caPrefix, uint64_t faceId);
+  fail(const std::string& msg);
 
   void
   runNdncert();
 
+  /**
+   * @brief Extract the CA certificate from discovery Data and check both
+   *
+   * The certificate must be self-signed and currently valid, and must have signed @p data.
+   * Malformed Data and failed checks are logged and yield false.
+   */
+  bool
+  decodeDiscoveryData(const Data& data, security::v2::Certificate& cert);
+
+  void
+  scheduleNdncertRetry();
+
+  void
+  onNdncertStep(StepClock& clock, LocationClientTool::Step step);
+
+  time::nanoseconds
+  getStepDeadline(LocationClientTool::Step step) const;
+
+  void
+  armStepDeadline(LocationClientTool::Step step);
+
   void
-  waitUntilFibEntryHasNextHop(const Name& prefix, uint64_t faceId,
-                              const std::function<void()>& continueCallback);
+  onCertificateIssued(bool isHedge);
+
+  void
+  startHedge();
+
+  /**
+   * @brief Register a route to the hedged CA and wait for its FIB entry, then call @p then
+   *
+   * Same as registerPrefixAndEnsureFibEntry, but keeps its state in m_hedge and abandons the
+   * hedge on failure instead of failing the session.
+   */
+  void
+  registerHedgeRoute(const Name& prefix, const std::function<void()>& then);
+
+  void
+  waitUntilHedgeFibEntryHasNextHop(const Name& prefix, size_t nRetriesLeft,
+                                   const std::function<void()>& then);
+
+  void
+  runHedgedNdncert();
+
+  bool
+  isHedgeRunning() const
+  {
+    return m_hedge != nullptr && m_hedge->isActive;
+  }
+
+  void
+  abandonHedge(const std::string& reason);
+
+  /**
+   * @brief Let the routes to a CA no longer in use lapse; /localhop/CA is kept if the CA in use
+   *        shares face @p faceId
+   */
+  void
+  releaseCaRoutes(const Name& caName, uint64_t faceId, uint64_t otherCaFaceId);
 
 public:
   int retval = 0;
@@ -77,19 +387,45 @@ public:
 private:
   util::signal::ScopedConnection m_onFailConnection;
   util::signal::ScopedConnection m_onSuccessConnection;
+  util::signal::ScopedConnection m_onStepConnection;
 
   KeyChain& m_keyChain;
   Face m_face;
   nfd::Controller m_controller;
-  Scheduler m_scheduler;
+  TimerWheel m_timers;
+  LoopMonitor m_loopMonitor;
+  RouteLeaseManager m_routes;
   std::unique_ptr<LocationClientTool> m_ndncertTool;
   std::unique_ptr<net::NetworkMonitor> m_networkMonitor;
-  util::scheduler::ScopedEventId m_rerunEvent;
+  std::unique_ptr<NetworkChangeFilter> m_networkFilter;
+  TimerWheel::ScopedTimerId m_rerunEvent;
   std::function<bool()> m_filterNetworkChange;
   ScopedPendingInterestHandle m_pi;
-  util::scheduler::ScopedEventId m_wait;
+  TimerWheel::ScopedTimerId m_wait;
+
+  SessionArena m_arena;
+  Session* m_session = nullptr; // owned by m_arena
+  uint64_t m_lastSessionId = 0;
+  mutable std::mutex m_arenaStatsMutex;
+  SessionArena::Stats m_lastSessionArenaStats;
+
+  std::map<uint64_t, RttEstimator> m_faceRtt;
+  std::map<Name, CaContext> m_caContexts;
+  CaVerifierCache m_verifiers;
+  CaLocationCache m_caLocations;
+  std::string m_network;
+  std::string m_interface;
+  util::signal::ScopedConnection m_enumerationConnection;
+
+  bool m_isHedgingEnabled = false;
+  StepClock m_primaryClock;
+  std::map<LocationClientTool::Step, LatencyWindow> m_stepLatency;
+  TimerWheel::ScopedTimerId m_stepDeadline;
+  ScopedPendingInterestHandle m_hedgePi;
+  std::unique_ptr<Hedge> m_hedge;
 
   bool m_gotCert = false;
+  std::atomic<bool> m_isStopping{false};
 };
 
 } // namespace ndncert
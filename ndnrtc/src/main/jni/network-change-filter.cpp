@@ -0,0 +1,221 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#include "network-change-filter.hpp"
+#include "binary-log.hpp"
+#include "metrics.hpp"
+
+#include <ndn-cxx/net/face-uri.hpp>
+#include <ndn-cxx/util/logger.hpp>
+
+#include <cstring>
+#include <sstream>
+
+namespace ndn {
+namespace ndncert {
+
+NDN_LOG_INIT(ndncert.NetworkChangeFilter);
+
+// cellular (Qualcomm, MediaTek, 464XLAT), VPN and tunnel interfaces, which may still look like
+// Ethernet to the kernel
+static const char* const NON_ACCESS_PREFIXES[] = {"rmnet", "ccmni", "v4-", "clat", "tun", "ppp",
+                                                  "ipsec", "dummy"};
+
+static bool
+isAccessInterface(const net::NetworkInterface& netif)
+{
+  if (netif.getType() != net::InterfaceType::ETHERNET || !netif.canMulticast() ||
+      netif.isPointToPoint()) {
+    return false;
+  }
+  for (const char* prefix : NON_ACCESS_PREFIXES) {
+    if (netif.getName().compare(0, std::strlen(prefix), prefix) == 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static bool
+isRelevantAddress(const net::NetworkAddress& address)
+{
+  return address.getFamily() == net::AddressFamily::V4 &&
+         address.getScope() == net::AddressScope::GLOBAL;
+}
+
+static bool
+isRunning(net::InterfaceState state)
+{
+  return state == net::InterfaceState::RUNNING;
+}
+
+NetworkChangeFilter::NetworkChangeFilter(net::NetworkMonitor& monitor,
+                                         boost::asio::io_service& ioService)
+  : m_monitor(monitor)
+  , m_ioService(ioService)
+{
+  const uint32_t NEEDED = net::NetworkMonitor::CAP_ENUM | net::NetworkMonitor::CAP_IF_ADD_REMOVE |
+                          net::NetworkMonitor::CAP_STATE_CHANGE |
+                          net::NetworkMonitor::CAP_ADDR_ADD_REMOVE;
+  if ((m_monitor.getCapabilities() & NEEDED) != NEEDED) {
+    NDN_LOG_DEBUG("No per-interface events on this platform, passing all network changes through");
+    m_monitorConnections.push_back(m_monitor.onNetworkStateChanged.connect([this] {
+        icear::metrics::add(icear::metrics::Counter::NETWORK_EVENTS);
+        icear::metrics::add(icear::metrics::Counter::NETWORK_CHANGES);
+        onNetworkChanged("");
+      }));
+    return;
+  }
+
+  m_monitorConnections.push_back(m_monitor.onEnumerationCompleted.connect([this] {
+        onEnumerationCompleted();
+      }));
+  m_monitorConnections.push_back(m_monitor.onInterfaceAdded.connect(
+    [this] (const shared_ptr<const net::NetworkInterface>& netif) {
+      watchInterface(netif);
+      onEvent(*netif, isRunning(netif->getState()));
+    }));
+  m_monitorConnections.push_back(m_monitor.onInterfaceRemoved.connect(
+    [this] (const shared_ptr<const net::NetworkInterface>& netif) {
+      m_interfaceConnections.erase(netif->getName());
+      onEvent(*netif, isRunning(netif->getState()));
+    }));
+}
+
+void
+NetworkChangeFilter::onEnumerationCompleted()
+{
+  for (const auto& netif : m_monitor.listNetworkInterfaces()) {
+    watchInterface(netif);
+  }
+  m_isEnumerated = true;
+  m_watchedState = getWatchedState();
+  NDN_LOG_DEBUG("Watching: " << m_watchedState);
+}
+
+void
+NetworkChangeFilter::watchInterface(const shared_ptr<const net::NetworkInterface>& netif)
+{
+  auto& connections = m_interfaceConnections[netif->getName()];
+  if (!connections.empty()) {
+    return;
+  }
+
+  // the handlers are owned by the interface's signals, so they never outlive it
+  const net::NetworkInterface* ifp = netif.get();
+  connections.push_back(netif->onStateChanged.connect(
+    [this, ifp] (net::InterfaceState oldState, net::InterfaceState newState) {
+      onEvent(*ifp, isRunning(oldState) != isRunning(newState));
+    }));
+  connections.push_back(netif->onAddressAdded.connect([this, ifp] (const net::NetworkAddress& address) {
+      onEvent(*ifp, isRelevantAddress(address));
+    }));
+  connections.push_back(netif->onAddressRemoved.connect([this, ifp] (const net::NetworkAddress& address) {
+      onEvent(*ifp, isRelevantAddress(address));
+    }));
+}
+
+void
+NetworkChangeFilter::setMultiAccessFaces(const std::vector<nfd::FaceStatus>& faces)
+{
+  m_faceInterfaces.clear();
+  m_faceAddresses.clear();
+  for (const auto& face : faces) {
+    FaceUri uri;
+    if (!uri.parse(face.getLocalUri())) {
+      continue;
+    }
+    if (uri.getScheme() == "dev") {
+      m_faceInterfaces.insert(uri.getHost());
+    }
+    else if (uri.getScheme() == "udp4" || uri.getScheme() == "udp") {
+      m_faceAddresses.insert(uri.getHost());
+    }
+  }
+
+  if (m_isEnumerated) {
+    // newly watched interfaces are not a change of the network
+    m_watchedState = getWatchedState();
+    NDN_LOG_DEBUG("Watching: " << m_watchedState);
+  }
+}
+
+bool
+NetworkChangeFilter::backsFace(const net::NetworkInterface& netif) const
+{
+  if (m_faceInterfaces.count(netif.getName()) > 0) {
+    return true;
+  }
+  for (const auto& address : netif.getNetworkAddresses()) {
+    if (m_faceAddresses.count(address.getIp().to_string()) > 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool
+NetworkChangeFilter::isWatched(const net::NetworkInterface& netif) const
+{
+  return backsFace(netif) || isAccessInterface(netif);
+}
+
+void
+NetworkChangeFilter::onEvent(const net::NetworkInterface& netif, bool isRelevant)
+{
+  icear::metrics::add(icear::metrics::Counter::NETWORK_EVENTS);
+  if (!m_isEnumerated || !isRelevant || !isWatched(netif)) {
+    return;
+  }
+
+  if (m_isComparisonScheduled) {
+    return;
+  }
+  m_isComparisonScheduled = true;
+  m_changedInterface = netif.getName();
+
+  // the monitor reports one change as several events (e.g., link, then each address), all of
+  // which are handled before this runs
+  std::weak_ptr<bool> isAlive = m_isAlive;
+  m_ioService.post([this, isAlive] {
+      if (isAlive.expired()) {
+        return;
+      }
+      m_isComparisonScheduled = false;
+
+      auto state = getWatchedState();
+      if (state == m_watchedState) {
+        return; // back to where it was, e.g., address removed and re-added
+      }
+      m_watchedState = state;
+
+      icear::metrics::add(icear::metrics::Counter::NETWORK_CHANGES);
+      ICEAR_BLOG_DEBUG(NETWORK_CHANGE, m_changedInterface, m_watchedState);
+      onNetworkChanged(m_changedInterface);
+    });
+}
+
+std::string
+NetworkChangeFilter::getWatchedState() const
+{
+  std::map<std::string, std::string> running;
+  for (const auto& netif : m_monitor.listNetworkInterfaces()) {
+    if (!isRunning(netif->getState()) || !isWatched(*netif)) {
+      continue;
+    }
+    std::string& addresses = running[netif->getName()];
+    for (const auto& address : netif->getNetworkAddresses()) { // ordered set
+      if (isRelevantAddress(address)) {
+        addresses += " " + address.getIp().to_string();
+      }
+    }
+  }
+
+  std::ostringstream os;
+  for (const auto& netif : running) {
+    os << netif.first << netif.second << "; ";
+  }
+  return os.str();
+}
+
+} // namespace ndncert
+} // namespace ndn
@@ -0,0 +1,96 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#ifndef ICEAR_NETWORK_CHANGE_FILTER_HPP
+#define ICEAR_NETWORK_CHANGE_FILTER_HPP
+
+#include <ndn-cxx/mgmt/nfd/face-status.hpp>
+#include <ndn-cxx/net/network-monitor.hpp>
+#include <ndn-cxx/util/noncopyable.hpp>
+#include <ndn-cxx/util/signal.hpp>
+
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace ndn {
+namespace ndncert {
+
+/**
+ * @brief Turns NetworkMonitor's per-interface events into changes of the networks we bootstrap on
+ *
+ * Only interfaces that back a multi-access face of the forwarder, or that could (Ethernet-like,
+ * multicast-capable, not point-to-point, not cellular or VPN), are watched.  On those, only
+ * transitions into or out of the RUNNING state and added or removed global IPv4 addresses count;
+ * IPv6 address churn (e.g., privacy address rotation), MTU changes and every event on other
+ * interfaces are dropped.  Events handled in the same turn of the I/O loop are collapsed, and
+ * onNetworkChanged is emitted only if the watched state actually differs from the last one seen.
+ *
+ * If the platform's monitor does not report per-interface events, every onNetworkStateChanged
+ * is passed through.  NETWORK_EVENTS and NETWORK_CHANGES metrics count events in and out.
+ */
+class NetworkChangeFilter : noncopyable
+{
+public:
+  NetworkChangeFilter(net::NetworkMonitor& monitor, boost::asio::io_service& ioService);
+
+  /**
+   * @brief Set the multi-access faces of the forwarder, whose interfaces are then always watched
+   *
+   * An interface backs a face if the face's local URI is `dev://<interface>`, or the interface has
+   * the address of `udp4://<address>:<port>` local URI.
+   */
+  void
+  setMultiAccessFaces(const std::vector<nfd::FaceStatus>& faces);
+
+public:
+  /// the networks we bootstrap on may have changed; the interface name is empty if unknown
+  util::Signal<NetworkChangeFilter, std::string> onNetworkChanged;
+
+private:
+  void
+  onEnumerationCompleted();
+
+  void
+  watchInterface(const shared_ptr<const net::NetworkInterface>& netif);
+
+  bool
+  backsFace(const net::NetworkInterface& netif) const;
+
+  bool
+  isWatched(const net::NetworkInterface& netif) const;
+
+  /**
+   * @brief Count the event and, if it is relevant to a watched interface, schedule a comparison
+   *        of the watched state, once per turn of the I/O loop
+   */
+  void
+  onEvent(const net::NetworkInterface& netif, bool isRelevant);
+
+  /**
+   * @brief Running watched interfaces and their global IPv4 addresses, as text
+   */
+  std::string
+  getWatchedState() const;
+
+private:
+  net::NetworkMonitor& m_monitor;
+  boost::asio::io_service& m_ioService;
+  std::vector<util::signal::ScopedConnection> m_monitorConnections;
+  std::map<std::string, std::vector<util::signal::ScopedConnection>> m_interfaceConnections;
+
+  std::set<std::string> m_faceInterfaces;
+  std::set<std::string> m_faceAddresses;
+
+  bool m_isEnumerated = false;
+  std::string m_watchedState;
+  std::string m_changedInterface; // of the first event since the last comparison
+  bool m_isComparisonScheduled = false;
+  // handlers posted to the I/O loop must not outlive this object
+  shared_ptr<bool> m_isAlive = make_shared<bool>(true);
+};
+
+} // namespace ndncert
+} // namespace ndn
+
+#endif // ICEAR_NETWORK_CHANGE_FILTER_HPP
@@ -0,0 +1,254 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#include "route-lease-manager.hpp"
+#include "metrics.hpp"
+
+#include <ndn-cxx/util/logger.hpp>
+
+namespace ndn {
+namespace ndncert {
+
+NDN_LOG_INIT(ndncert.RouteLeaseManager);
+
+using nfd::ControlParameters;
+using nfd::ControlResponse;
+
+RouteLeaseManager::RouteLeaseManager(nfd::Controller& controller, TimerWheel& timers,
+                                     uint64_t cost, time::milliseconds expiration)
+  : m_controller(controller)
+  , m_timers(timers)
+  , m_cost(cost)
+  , m_expiration(expiration)
+  , m_refreshMargin(expiration / 4)
+{
+}
+
+bool
+RouteLeaseManager::hasValidLease(const LeaseKey& key) const
+{
+  auto lease = m_leases.find(key);
+  return lease != m_leases.end() && lease->second.expiry - time::steady_clock::now() > m_refreshMargin;
+}
+
+void
+RouteLeaseManager::syncWithRib(const std::function<void()>& done)
+{
+  m_controller.fetch<nfd::RibDataset>(
+    [this, done] (const std::vector<nfd::RibEntry>& rib) {
+      auto now = time::steady_clock::now();
+
+      // only routes we hold a lease for are looked at: the same prefix may be registered by
+      // another application (or another terminal of this process) and is none of our business
+      std::map<LeaseKey, time::steady_clock::TimePoint> ribRoutes; // => expiry
+      for (const auto& entry : rib) {
+        for (const auto& route : entry.getRoutes()) {
+          LeaseKey key(entry.getName(), route.getFaceId());
+          if (route.getOrigin() != nfd::ROUTE_ORIGIN_APP || m_leases.count(key) == 0) {
+            continue;
+          }
+          ribRoutes[key] = route.hasExpirationPeriod() ?
+            now + route.getExpirationPeriod() : time::steady_clock::TimePoint::max();
+        }
+      }
+
+      for (auto lease = m_leases.begin(); lease != m_leases.end();) {
+        auto route = ribRoutes.find(lease->first);
+        if (route == ribRoutes.end()) {
+          NDN_LOG_DEBUG("Route " << lease->first.first << " via " << lease->first.second << " is gone from RIB");
+          lease = m_leases.erase(lease);
+        }
+        else {
+          lease->second.expiry = route->second;
+          ++lease;
+        }
+      }
+
+      NDN_LOG_TRACE(m_leases.size() << " route leases still in RIB");
+      scheduleRefresh();
+      done();
+    },
+    [done] (uint32_t code, const std::string& reason) {
+      // not fatal: without the snapshot every route simply gets registered
+      NDN_LOG_WARN("Error " << code << " when fetching RIB: " << reason);
+      done();
+    });
+}
+
+void
+RouteLeaseManager::registerRoute(const Name& prefix, uint64_t faceId, uint64_t sessionId,
+                                 const RegisterCallback& onSuccess, const FailureCallback& onFailure)
+{
+  LeaseKey key(prefix, faceId);
+  if (hasValidLease(key)) {
+    NDN_LOG_TRACE("Route " << prefix << " via " << faceId << " is already leased");
+    Lease& lease = m_leases[key];
+    bool wasReleased = lease.sessionId == 0;
+    lease.sessionId = sessionId;
+    if (wasReleased) {
+      scheduleRefresh();
+    }
+    onSuccess(true);
+    return;
+  }
+
+  ControlParameters parameters;
+  parameters.setName(prefix)
+    .setFaceId(faceId)
+    .setCost(m_cost)
+    .setExpirationPeriod(m_expiration);
+
+  icear::metrics::add(icear::metrics::Counter::ROUTE_REGISTRATIONS);
+  m_controller.start<nfd::RibRegisterCommand>(
+    parameters,
+    [this, key, sessionId, onSuccess] (const ControlParameters&) {
+      m_leases[key] = {time::steady_clock::now() + m_expiration, sessionId};
+      scheduleRefresh();
+      onSuccess(false);
+    },
+    [onFailure] (const ControlResponse& resp) {
+      icear::metrics::add(icear::metrics::Counter::ROUTE_REGISTRATION_FAILURES);
+      onFailure(to_string(resp.getCode()) + " " + resp.getText());
+    });
+}
+
+void
+RouteLeaseManager::releaseRoute(const Name& prefix, uint64_t faceId)
+{
+  auto lease = m_leases.find({prefix, faceId});
+  if (lease == m_leases.end() || lease->second.sessionId == 0) {
+    return;
+  }
+  NDN_LOG_TRACE("Releasing route " << prefix << " via " << faceId);
+  lease->second.sessionId = 0;
+  scheduleRefresh();
+}
+
+void
+RouteLeaseManager::releaseSession(uint64_t sessionId)
+{
+  size_t nReleased = 0;
+  for (auto& lease : m_leases) {
+    if (lease.second.sessionId == sessionId) {
+      lease.second.sessionId = 0;
+      ++nReleased;
+    }
+  }
+  if (nReleased > 0) {
+    NDN_LOG_DEBUG("Released " << nReleased << " route leases of session " << sessionId);
+    scheduleRefresh();
+  }
+}
+
+void
+RouteLeaseManager::scheduleRefresh()
+{
+  auto now = time::steady_clock::now();
+  auto earliest = time::steady_clock::TimePoint::max();
+  for (auto lease = m_leases.begin(); lease != m_leases.end();) {
+    if (lease->second.sessionId != 0) {
+      earliest = std::min(earliest, lease->second.expiry);
+      ++lease;
+    }
+    else if (lease->second.expiry <= now) {
+      lease = m_leases.erase(lease); // lapsed
+    }
+    else {
+      ++lease;
+    }
+  }
+
+  // follows every change of the lease set, except failed refreshes and withdrawal
+  icear::metrics::set(icear::metrics::Gauge::ROUTE_LEASES, m_leases.size());
+
+  if (earliest == time::steady_clock::TimePoint::max()) {
+    m_refreshEvent.cancel();
+    return;
+  }
+
+  auto delay = time::duration_cast<time::nanoseconds>(earliest - m_refreshMargin - now);
+  // refreshLeases() renews everything within the margin, so the refresh may be late by a fraction of it
+  m_refreshEvent = m_timers.schedule(std::max(delay, time::nanoseconds::zero()), m_refreshMargin / 4, [this] {
+      refreshLeases();
+    });
+}
+
+void
+RouteLeaseManager::refreshLeases()
+{
+  auto now = time::steady_clock::now();
+  // refresh everything that would come due soon in the same batch, to avoid one wakeup per route
+  auto horizon = now + 2 * m_refreshMargin;
+
+  size_t nRefreshed = 0;
+  for (auto& lease : m_leases) {
+    if (lease.second.sessionId == 0 || lease.second.expiry > horizon) {
+      continue;
+    }
+    // optimistic: the lease is dropped if the refresh fails
+    lease.second.expiry = now + m_expiration;
+
+    LeaseKey key = lease.first;
+    ControlParameters parameters;
+    parameters.setName(key.first)
+      .setFaceId(key.second)
+      .setCost(m_cost)
+      .setExpirationPeriod(m_expiration);
+
+    m_controller.start<nfd::RibRegisterCommand>(
+      parameters,
+      [] (const ControlParameters&) {},
+      [this, key] (const ControlResponse& resp) {
+        NDN_LOG_WARN("Cannot refresh route " << key.first << " via " << key.second << ": " << resp);
+        m_leases.erase(key);
+        icear::metrics::set(icear::metrics::Gauge::ROUTE_LEASES, m_leases.size());
+      });
+    ++nRefreshed;
+  }
+
+  NDN_LOG_DEBUG("Refreshed " << nRefreshed << " of " << m_leases.size() << " route leases");
+  scheduleRefresh();
+}
+
+void
+RouteLeaseManager::withdrawAll(const std::function<void()>& done, time::milliseconds timeout)
+{
+  m_refreshEvent.cancel();
+
+  if (m_leases.empty()) {
+    done();
+    return;
+  }
+
+  NDN_LOG_DEBUG("Withdrawing " << m_leases.size() << " routes");
+
+  auto nPending = std::make_shared<size_t>(m_leases.size());
+  auto isFinished = std::make_shared<bool>(false);
+  auto finish = [this, done, isFinished] {
+    if (*isFinished) {
+      return;
+    }
+    *isFinished = true;
+    m_withdrawTimeout.cancel();
+    done();
+  };
+
+  for (const auto& lease : m_leases) {
+    ControlParameters parameters;
+    parameters.setName(lease.first.first)
+      .setFaceId(lease.first.second);
+
+    auto onComplete = [nPending, finish] (const auto&) {
+      if (--*nPending == 0) {
+        finish();
+      }
+    };
+    m_controller.start<nfd::RibUnregisterCommand>(parameters, onComplete, onComplete);
+  }
+  m_leases.clear();
+  icear::metrics::set(icear::metrics::Gauge::ROUTE_LEASES, 0);
+
+  m_withdrawTimeout = m_timers.schedule(timeout, timeout / 10, finish);
+}
+
+} // namespace ndncert
+} // namespace ndn
@@ -0,0 +1,116 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#ifndef ICEAR_ROUTE_LEASE_MANAGER_HPP
+#define ICEAR_ROUTE_LEASE_MANAGER_HPP
+
+#include "timer-wheel.hpp"
+
+#include <ndn-cxx/mgmt/nfd/controller.hpp>
+#include <ndn-cxx/mgmt/nfd/rib-entry.hpp>
+
+#include <map>
+
+namespace ndn {
+namespace ndncert {
+
+/**
+ * @brief Tracks routes registered by MobileTerminal and keeps their leases alive
+ *
+ * Routes are registered with a finite expiration period, on behalf of a bootstrap session.  The
+ * manager re-registers the leases of sessions still using them that are close to expiry in one
+ * batch, skips registrations of routes it already holds a lease with enough lifetime left for,
+ * and withdraws everything on shutdown.  Released leases (of a finished session, or of a CA no
+ * longer in use) are not refreshed and lapse, unless a session registers the route again before.
+ * Routes it did not register itself are never adopted, even if they match.
+ */
+class RouteLeaseManager : noncopyable
+{
+public:
+  /**
+   * @param wasRegistered true if the route already existed and no command was sent
+   */
+  using RegisterCallback = std::function<void(bool wasRegistered)>;
+  using FailureCallback = std::function<void(const std::string& reason)>;
+
+  RouteLeaseManager(nfd::Controller& controller, TimerWheel& timers,
+                    uint64_t cost, time::milliseconds expiration);
+
+  /**
+   * @brief Reconcile tracked leases with the RIB
+   *
+   * Leases that disappeared from the RIB (e.g., NFD restart or face gone) are forgotten, and the
+   * others take the remaining lifetime the RIB reports for them.
+   */
+  void
+  syncWithRib(const std::function<void()>& done);
+
+  /**
+   * @brief Register route (unless a lease with enough lifetime left exists) and track its lease
+   *        for session @p sessionId, which takes an existing lease over
+   */
+  void
+  registerRoute(const Name& prefix, uint64_t faceId, uint64_t sessionId,
+                const RegisterCallback& onSuccess, const FailureCallback& onFailure);
+
+  /**
+   * @brief Stop refreshing the route, which then lapses
+   */
+  void
+  releaseRoute(const Name& prefix, uint64_t faceId);
+
+  /**
+   * @brief Stop refreshing the routes of session @p sessionId, which then lapse
+   *
+   * Refreshes dropped by Face::shutdown need no care: the next session takes the lifetimes of the
+   * routes it may reuse from the RIB (syncWithRib) before registering them.
+   */
+  void
+  releaseSession(uint64_t sessionId);
+
+  /**
+   * @brief Unregister all tracked routes
+   * @param done called once all unregistrations completed or @p timeout elapsed
+   */
+  void
+  withdrawAll(const std::function<void()>& done, time::milliseconds timeout);
+
+  size_t
+  size() const
+  {
+    return m_leases.size();
+  }
+
+private:
+  using LeaseKey = std::pair<Name, uint64_t>;
+
+  struct Lease
+  {
+    time::steady_clock::TimePoint expiry;
+    uint64_t sessionId; ///< session using the route, 0 if released
+  };
+
+  bool
+  hasValidLease(const LeaseKey& key) const;
+
+  void
+  scheduleRefresh();
+
+  void
+  refreshLeases();
+
+private:
+  nfd::Controller& m_controller;
+  TimerWheel& m_timers;
+  const uint64_t m_cost;
+  const time::milliseconds m_expiration;
+  const time::milliseconds m_refreshMargin;
+
+  std::map<LeaseKey, Lease> m_leases;
+  TimerWheel::ScopedTimerId m_refreshEvent;
+  TimerWheel::ScopedTimerId m_withdrawTimeout;
+};
+
+} // namespace ndncert
+} // namespace ndn
+
+#endif // ICEAR_ROUTE_LEASE_MANAGER_HPP
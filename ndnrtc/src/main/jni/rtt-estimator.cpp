@@ -0,0 +1,77 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#include "rtt-estimator.hpp"
+
+#include <algorithm>
+
+namespace ndn {
+namespace ndncert {
+
+RttEstimator::Options
+RttEstimator::getDefaultOptions()
+{
+  Options options;
+  options.alpha = 0.125;
+  options.beta = 0.25;
+  options.k = 4;
+  options.initialRto = 1_s;
+  // RFC 6298 recommends 1 s floor, but on a local AP the CA is a single hop away and
+  // lost packets should be retried within tens of milliseconds
+  options.minRto = 50_ms;
+  options.maxRto = 4_s;
+  options.rtoBackoffMultiplier = 2;
+  return options;
+}
+
+RttEstimator::RttEstimator()
+  : RttEstimator(getDefaultOptions())
+{
+}
+
+RttEstimator::RttEstimator(const Options& options)
+  : m_options(options)
+  , m_sRtt(0)
+  , m_rttVar(0)
+  , m_rto(options.initialRto)
+  , m_minRtt(time::nanoseconds::max())
+{
+}
+
+void
+RttEstimator::addMeasurement(time::nanoseconds rtt)
+{
+  if (m_nSamples == 0) {
+    m_sRtt = rtt;
+    m_rttVar = rtt / 2;
+  }
+  else {
+    time::nanoseconds delta = m_sRtt > rtt ? m_sRtt - rtt : rtt - m_sRtt;
+    m_rttVar = time::duration_cast<time::nanoseconds>((1 - m_options.beta) * m_rttVar +
+                                                      m_options.beta * delta);
+    m_sRtt = time::duration_cast<time::nanoseconds>((1 - m_options.alpha) * m_sRtt +
+                                                    m_options.alpha * rtt);
+  }
+  ++m_nSamples;
+  m_minRtt = std::min(m_minRtt, rtt);
+
+  m_rto = std::max(m_options.minRto, std::min(m_options.maxRto, m_sRtt + m_options.k * m_rttVar));
+}
+
+void
+RttEstimator::backoffRto()
+{
+  m_rto = std::min(m_options.maxRto, m_rto * m_options.rtoBackoffMultiplier);
+}
+
+time::milliseconds
+RttEstimator::getInterestLifetime() const
+{
+  auto lifetime = time::duration_cast<time::milliseconds>(m_rto);
+  if (lifetime < m_rto) {
+    lifetime += 1_ms;
+  }
+  return lifetime;
+}
+
+} // namespace ndncert
+} // namespace ndn
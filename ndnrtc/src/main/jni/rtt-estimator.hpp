@@ -0,0 +1,101 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#ifndef ICEAR_RTT_ESTIMATOR_HPP
+#define ICEAR_RTT_ESTIMATOR_HPP
+
+#include <ndn-cxx/util/time.hpp>
+
+namespace ndn {
+namespace ndncert {
+
+/**
+ * @brief RTT estimator in the style of RFC 6298 (SRTT/RTTVAR/RTO)
+ *
+ * Used to pick Interest lifetimes and retransmission timing for the discovery
+ * (per-face) and NDNCERT (per-CA) exchanges instead of fixed multi-second values.
+ */
+class RttEstimator
+{
+public:
+  struct Options
+  {
+    double alpha; ///< weight of the latest sample in SRTT
+    double beta;  ///< weight of the latest sample in RTTVAR
+    int k;        ///< RTTVAR multiplier in RTO
+    time::nanoseconds initialRto;
+    time::nanoseconds minRto;
+    time::nanoseconds maxRto;
+    int rtoBackoffMultiplier;
+  };
+
+  static Options
+  getDefaultOptions();
+
+  RttEstimator();
+
+  explicit
+  RttEstimator(const Options& options);
+
+  /**
+   * @brief Add new RTT sample
+   *
+   * Only samples from Interests that were not retransmitted must be added (Karn's algorithm).
+   */
+  void
+  addMeasurement(time::nanoseconds rtt);
+
+  /**
+   * @brief Back off RTO after a timeout (up to maxRto)
+   */
+  void
+  backoffRto();
+
+  time::nanoseconds
+  getEstimatedRto() const
+  {
+    return m_rto;
+  }
+
+  /**
+   * @brief Get RTO rounded up to a value suitable for InterestLifetime
+   */
+  time::milliseconds
+  getInterestLifetime() const;
+
+  bool
+  hasSamples() const
+  {
+    return m_nSamples > 0;
+  }
+
+  time::nanoseconds
+  getSmoothedRtt() const
+  {
+    return m_sRtt;
+  }
+
+  time::nanoseconds
+  getRttVariation() const
+  {
+    return m_rttVar;
+  }
+
+  time::nanoseconds
+  getMinRtt() const
+  {
+    return m_minRtt;
+  }
+
+private:
+  Options m_options;
+  time::nanoseconds m_sRtt;
+  time::nanoseconds m_rttVar;
+  time::nanoseconds m_rto;
+  time::nanoseconds m_minRtt;
+  size_t m_nSamples = 0;
+};
+
+} // namespace ndncert
+} // namespace ndn
+
+#endif // ICEAR_RTT_ESTIMATOR_HPP
@@ -0,0 +1,81 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#include "session-arena.hpp"
+
+#include <algorithm>
+
+namespace ndn {
+namespace ndncert {
+
+SessionArena::SessionArena(size_t chunkSize)
+  : m_chunkSize(chunkSize)
+  , m_firstChunk(allocateChunk(chunkSize))
+  , m_chunks(m_firstChunk)
+{
+  useChunk(m_firstChunk);
+}
+
+SessionArena::~SessionArena()
+{
+  release();
+  ::operator delete(m_firstChunk);
+}
+
+SessionArena::Chunk*
+SessionArena::allocateChunk(size_t size)
+{
+  auto chunk = static_cast<Chunk*>(::operator new(sizeof(Chunk) + size));
+  chunk->next = nullptr;
+  chunk->size = size;
+  return chunk;
+}
+
+void
+SessionArena::useChunk(Chunk* chunk)
+{
+  m_current = reinterpret_cast<uintptr_t>(chunk + 1);
+  m_end = m_current + chunk->size;
+}
+
+void*
+SessionArena::allocate(size_t size, size_t alignment)
+{
+  uintptr_t start = (m_current + alignment - 1) & ~(static_cast<uintptr_t>(alignment) - 1);
+  if (start + size > m_end) {
+    Chunk* chunk = allocateChunk(std::max(m_chunkSize, size + alignment));
+    chunk->next = m_chunks;
+    m_chunks = chunk;
+    useChunk(chunk);
+    ++m_stats.nHeapChunks;
+
+    start = (m_current + alignment - 1) & ~(static_cast<uintptr_t>(alignment) - 1);
+  }
+
+  m_current = start + size;
+  ++m_stats.nAllocations;
+  m_stats.nBytes += size;
+  return reinterpret_cast<void*>(start);
+}
+
+void
+SessionArena::release()
+{
+  // destroy in reverse order of creation
+  while (m_finalizers != nullptr) {
+    Finalizer* finalizer = m_finalizers;
+    m_finalizers = finalizer->next;
+    finalizer->destroy(finalizer->object);
+  }
+
+  while (m_chunks != m_firstChunk) {
+    Chunk* chunk = m_chunks;
+    m_chunks = chunk->next;
+    ::operator delete(chunk);
+  }
+
+  useChunk(m_firstChunk);
+  m_stats = Stats();
+}
+
+} // namespace ndncert
+} // namespace ndn
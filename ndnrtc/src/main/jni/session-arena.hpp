@@ -0,0 +1,220 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#ifndef ICEAR_SESSION_ARENA_HPP
+#define ICEAR_SESSION_ARENA_HPP
+
+#include <ndn-cxx/util/noncopyable.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <streambuf>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace ndn {
+namespace ndncert {
+
+/**
+ * @brief Monotonic memory resource for objects that live for one bootstrap session
+ *
+ * Memory is carved out of chunks and never returned piecemeal; release() destroys all objects
+ * created with create() and rewinds the arena in one operation.  The first chunk is kept across
+ * sessions, so a session that fits into it does not touch the global heap for what it draws from
+ * the arena: its own state and containers, and the scratch of the NDNCERT exchanges (decoded and
+ * decrypted challenge codes, serialized JSON and TLV of localhop validation).  ndn-cxx objects
+ * (names, Interests, control parameters), ndncert's JSON property trees and callbacks have no
+ * allocator hooks and still come from the global heap.
+ */
+class SessionArena : noncopyable
+{
+public:
+  struct Stats
+  {
+    size_t nAllocations = 0;   ///< allocations served from the arena
+    size_t nBytes = 0;         ///< bytes requested (without alignment padding)
+    size_t nHeapChunks = 0;    ///< overflow chunks that had to come from the global heap
+  };
+
+  explicit
+  SessionArena(size_t chunkSize = 4096);
+
+  ~SessionArena();
+
+  void*
+  allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+
+  /**
+   * @brief Construct an object in the arena; it is destroyed by release()
+   */
+  template<typename T, typename... Args>
+  T*
+  create(Args&&... args)
+  {
+    T* object = new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+    if (!std::is_trivially_destructible<T>::value) {
+      auto finalizer = static_cast<Finalizer*>(allocate(sizeof(Finalizer), alignof(Finalizer)));
+      finalizer->destroy = [] (void* p) { static_cast<T*>(p)->~T(); };
+      finalizer->object = object;
+      finalizer->next = m_finalizers;
+      m_finalizers = finalizer;
+    }
+    return object;
+  }
+
+  /**
+   * @brief Destroy all objects created in the arena and release its memory
+   */
+  void
+  release();
+
+  /**
+   * @brief Statistics since the last release()
+   */
+  const Stats&
+  getStats() const
+  {
+    return m_stats;
+  }
+
+private:
+  struct Chunk
+  {
+    Chunk* next;
+    size_t size;
+  };
+
+  struct Finalizer
+  {
+    void (*destroy)(void*);
+    void* object;
+    Finalizer* next;
+  };
+
+  static Chunk*
+  allocateChunk(size_t size);
+
+  void
+  useChunk(Chunk* chunk);
+
+private:
+  const size_t m_chunkSize;
+  Chunk* m_firstChunk;
+  Chunk* m_chunks;
+  uintptr_t m_current;
+  uintptr_t m_end;
+  Finalizer* m_finalizers = nullptr;
+  Stats m_stats;
+};
+
+/**
+ * @brief Standard allocator drawing from SessionArena, for containers owned by a session
+ */
+template<typename T>
+class ArenaAllocator
+{
+public:
+  using value_type = T;
+
+  explicit
+  ArenaAllocator(SessionArena& arena) noexcept
+    : m_arena(&arena)
+  {
+  }
+
+  template<typename U>
+  ArenaAllocator(const ArenaAllocator<U>& other) noexcept
+    : m_arena(other.getArena())
+  {
+  }
+
+  T*
+  allocate(size_t n)
+  {
+    return static_cast<T*>(m_arena->allocate(n * sizeof(T), alignof(T)));
+  }
+
+  void
+  deallocate(T*, size_t) noexcept
+  {
+    // memory is reclaimed by SessionArena::release()
+  }
+
+  SessionArena*
+  getArena() const noexcept
+  {
+    return m_arena;
+  }
+
+private:
+  SessionArena* m_arena;
+};
+
+template<typename T, typename U>
+bool
+operator==(const ArenaAllocator<T>& lhs, const ArenaAllocator<U>& rhs) noexcept
+{
+  return lhs.getArena() == rhs.getArena();
+}
+
+template<typename T, typename U>
+bool
+operator!=(const ArenaAllocator<T>& lhs, const ArenaAllocator<U>& rhs) noexcept
+{
+  return !(lhs == rhs);
+}
+
+using ArenaString = std::basic_string<char, std::char_traits<char>, ArenaAllocator<char>>;
+
+/**
+ * @brief Output stream buffer collecting what is written into arena memory, for scratch encodings
+ */
+class ArenaStreamBuf : public std::streambuf
+{
+public:
+  explicit
+  ArenaStreamBuf(SessionArena& arena, size_t capacity = 256)
+    : m_data(ArenaAllocator<char>(arena))
+  {
+    m_data.reserve(capacity);
+  }
+
+  const uint8_t*
+  data() const
+  {
+    return reinterpret_cast<const uint8_t*>(m_data.data());
+  }
+
+  size_t
+  size() const
+  {
+    return m_data.size();
+  }
+
+protected:
+  int_type
+  overflow(int_type ch) override
+  {
+    if (!traits_type::eq_int_type(ch, traits_type::eof())) {
+      m_data.push_back(traits_type::to_char_type(ch));
+    }
+    return traits_type::not_eof(ch);
+  }
+
+  std::streamsize
+  xsputn(const char* s, std::streamsize n) override
+  {
+    m_data.insert(m_data.end(), s, s + n);
+    return n;
+  }
+
+private:
+  std::vector<char, ArenaAllocator<char>> m_data;
+};
+
+} // namespace ndncert
+} // namespace ndn
+
+#endif // ICEAR_SESSION_ARENA_HPP
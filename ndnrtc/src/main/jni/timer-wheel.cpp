@@ -0,0 +1,244 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#include "timer-wheel.hpp"
+
+#include <algorithm>
+#include <limits>
+
+namespace ndn {
+namespace ndncert {
+
+constexpr size_t TimerWheel::N_LEVELS;
+constexpr size_t TimerWheel::LEVEL_SHIFT;
+constexpr size_t TimerWheel::N_SLOTS;
+
+void
+TimerWheel::TimerId::cancel()
+{
+  auto timer = m_timer.lock();
+  if (timer != nullptr) {
+    timer->wheel->cancel(*timer);
+  }
+  m_timer.reset();
+}
+
+TimerWheel::TimerId::operator bool() const
+{
+  auto timer = m_timer.lock();
+  return timer != nullptr && timer->state != Timer::DONE;
+}
+
+double
+TimerWheel::Stats::getWakeupsPerHour() const
+{
+  double hours = time::duration_cast<time::milliseconds>(time::steady_clock::now() - since).count() / 3600000.0;
+  return hours > 0 ? nWakeups / hours : 0;
+}
+
+TimerWheel::TimerWheel(boost::asio::io_service& ioService)
+  : m_timer(ioService)
+  , m_epoch(time::steady_clock::now())
+  , m_armedFor(time::steady_clock::TimePoint::max())
+{
+  m_stats.since = m_epoch;
+}
+
+TimerWheel::~TimerWheel()
+{
+  cancelAll();
+}
+
+uint64_t
+TimerWheel::toTick(time::steady_clock::TimePoint tp) const
+{
+  return tp > m_epoch ? time::duration_cast<time::milliseconds>(tp - m_epoch).count() : 0;
+}
+
+time::steady_clock::TimePoint
+TimerWheel::fromTick(uint64_t tick) const
+{
+  return m_epoch + time::milliseconds(tick);
+}
+
+TimerWheel::TimerId
+TimerWheel::schedule(time::nanoseconds after, time::nanoseconds slack, const Callback& callback)
+{
+  auto timer = std::make_shared<Timer>();
+  timer->wheel = this;
+  timer->callback = callback;
+  timer->deadline = time::steady_clock::now() + std::max(after, time::nanoseconds::zero());
+
+  uint64_t slackTicks = std::max<int64_t>(time::duration_cast<time::milliseconds>(slack).count(), 0);
+  size_t level = 0;
+  while (level + 1 < N_LEVELS && getGranularity(level + 1) <= slackTicks) {
+    ++level;
+  }
+
+  // round the deadline up to a whole tick, then up to the granularity of the level
+  uint64_t deadlineTick = toTick(timer->deadline);
+  if (fromTick(deadlineTick) < timer->deadline) {
+    ++deadlineTick;
+  }
+  uint64_t granularity = getGranularity(level);
+  timer->wakeupTick = (deadlineTick + granularity - 1) / granularity * granularity;
+  timer->level = level;
+
+  Slot& slot = getSlot(level, timer->wakeupTick);
+  timer->position = slot.insert(slot.end(), timer);
+  ++m_levelSizes[level];
+  ++m_size;
+  ++m_stats.nScheduled;
+
+  if (!m_isExpiring && fromTick(timer->wakeupTick) < m_armedFor) {
+    arm();
+  }
+  return TimerId(timer);
+}
+
+void
+TimerWheel::cancel(Timer& timer)
+{
+  if (timer.state == Timer::SCHEDULED) {
+    --m_levelSizes[timer.level];
+    --m_size;
+    timer.state = Timer::DONE;
+    // may release the last reference other than the caller's
+    getSlot(timer.level, timer.wakeupTick).erase(timer.position);
+
+    // otherwise the wheel would wake up for nothing, e.g., when a debounce timer is pushed back
+    if (!m_isExpiring && fromTick(timer.wakeupTick) == m_armedFor) {
+      arm();
+    }
+  }
+  else if (timer.state == Timer::EXPIRED) {
+    timer.state = Timer::DONE;
+  }
+}
+
+void
+TimerWheel::cancelAll()
+{
+  for (size_t level = 0; level < N_LEVELS; ++level) {
+    for (auto& slot : m_levels[level]) {
+      for (auto& timer : slot) {
+        timer->state = Timer::DONE;
+      }
+      slot.clear();
+    }
+    m_levelSizes[level] = 0;
+  }
+  for (auto& timer : m_expired) {
+    timer->state = Timer::DONE;
+  }
+  m_size = 0;
+
+  m_timer.cancel();
+  m_armedFor = time::steady_clock::TimePoint::max();
+}
+
+void
+TimerWheel::arm()
+{
+  // wheel holds a handful of timers, a full scan is cheaper than keeping them ordered
+  uint64_t earliest = std::numeric_limits<uint64_t>::max();
+  for (size_t level = 0; level < N_LEVELS; ++level) {
+    if (m_levelSizes[level] == 0) {
+      continue;
+    }
+    for (const auto& slot : m_levels[level]) {
+      for (const auto& timer : slot) {
+        earliest = std::min(earliest, timer->wakeupTick);
+      }
+    }
+  }
+
+  if (earliest == std::numeric_limits<uint64_t>::max()) {
+    m_timer.cancel();
+    m_armedFor = time::steady_clock::TimePoint::max();
+    return;
+  }
+
+  auto wakeup = fromTick(earliest);
+  if (wakeup == m_armedFor) {
+    return;
+  }
+  m_armedFor = wakeup;
+  m_timer.expires_at(wakeup);
+  m_timer.async_wait([this] (const boost::system::error_code& error) {
+      if (error) { // cancelled or re-armed
+        return;
+      }
+      m_armedFor = time::steady_clock::TimePoint::max();
+      expire();
+    });
+}
+
+void
+TimerWheel::expire()
+{
+  ++m_stats.nWakeups;
+  auto now = time::steady_clock::now();
+  uint64_t nowTick = toTick(now);
+
+  for (size_t level = 0; level < N_LEVELS; ++level) {
+    uint64_t currentSlot = nowTick >> (LEVEL_SHIFT * level);
+    if (m_levelSizes[level] > 0) {
+      // timers of the slot after the current one may already be past their deadline as well
+      uint64_t first = m_nextSlot[level];
+      uint64_t last = currentSlot + 1;
+      if (last - first >= N_SLOTS) {
+        first = last + 1 - N_SLOTS;
+      }
+      for (uint64_t i = first; i <= last; ++i) {
+        Slot& slot = m_levels[level][i % N_SLOTS];
+        for (auto it = slot.begin(); it != slot.end();) {
+          if ((*it)->deadline <= now) {
+            (*it)->state = Timer::EXPIRED;
+            m_expired.push_back(std::move(*it));
+            it = slot.erase(it);
+            --m_levelSizes[level];
+            --m_size;
+          }
+          else {
+            ++it;
+          }
+        }
+      }
+    }
+    m_nextSlot[level] = currentSlot;
+  }
+
+  std::stable_sort(m_expired.begin(), m_expired.end(), [] (const auto& a, const auto& b) {
+      return a->deadline < b->deadline;
+    });
+
+  m_isExpiring = true;
+  try {
+    for (size_t i = 0; i < m_expired.size(); ++i) {
+      auto timer = m_expired[i];
+      // a callback that ran earlier in this wakeup could have cancelled the timer
+      if (timer->state == Timer::EXPIRED) {
+        timer->state = Timer::DONE;
+        ++m_stats.nFired;
+        timer->callback();
+      }
+    }
+  }
+  catch (...) {
+    // timers left in the batch are dropped along with the failed wakeup
+    for (auto& timer : m_expired) {
+      timer->state = Timer::DONE;
+    }
+    m_expired.clear();
+    m_isExpiring = false;
+    arm();
+    throw;
+  }
+  m_expired.clear();
+  m_isExpiring = false;
+
+  arm();
+}
+
+} // namespace ndncert
+} // namespace ndn
@@ -0,0 +1,222 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#ifndef ICEAR_TIMER_WHEEL_HPP
+#define ICEAR_TIMER_WHEEL_HPP
+
+#include <ndn-cxx/util/detail/steady-timer.hpp>
+#include <ndn-cxx/util/noncopyable.hpp>
+#include <ndn-cxx/util/time.hpp>
+
+#include <array>
+#include <functional>
+#include <list>
+#include <memory>
+#include <vector>
+
+namespace ndn {
+namespace ndncert {
+
+/**
+ * @brief Hierarchical timer wheel that coalesces timers with slack into shared wakeups
+ *
+ * A timer scheduled with @p slack may fire anywhere between its deadline and deadline + slack.
+ * Level L of the wheel has 8^L ms granularity, and a timer goes to the coarsest level whose
+ * granularity does not exceed its slack, with its wakeup rounded up to that granularity; timers
+ * with nearby deadlines thus land on the same wakeup.  When the wheel wakes up, it also fires
+ * every timer whose deadline has already passed, even if its own wakeup would come later.
+ *
+ * Only one steady timer is armed on the io_service at a time, for the earliest wakeup.
+ */
+class TimerWheel : noncopyable
+{
+private:
+  struct Timer;
+
+public:
+  using Callback = std::function<void()>;
+
+  /**
+   * @brief Handle of a scheduled timer; does not cancel the timer when destroyed
+   */
+  class TimerId
+  {
+  public:
+    TimerId() = default;
+
+    /**
+     * @brief Cancel the timer, if it has not fired yet
+     */
+    void
+    cancel();
+
+    /**
+     * @return true if the timer has neither fired nor been cancelled
+     */
+    explicit
+    operator bool() const;
+
+  private:
+    explicit
+    TimerId(std::weak_ptr<Timer> timer)
+      : m_timer(std::move(timer))
+    {
+    }
+
+  private:
+    std::weak_ptr<Timer> m_timer;
+
+    friend class TimerWheel;
+  };
+
+  /**
+   * @brief Handle that cancels the timer when destroyed or assigned a new timer
+   */
+  class ScopedTimerId : noncopyable
+  {
+  public:
+    ScopedTimerId() = default;
+
+    ScopedTimerId(TimerId id)
+      : m_id(std::move(id))
+    {
+    }
+
+    ScopedTimerId&
+    operator=(TimerId id)
+    {
+      m_id.cancel();
+      m_id = std::move(id);
+      return *this;
+    }
+
+    ~ScopedTimerId()
+    {
+      m_id.cancel();
+    }
+
+    void
+    cancel()
+    {
+      m_id.cancel();
+    }
+
+    explicit
+    operator bool() const
+    {
+      return static_cast<bool>(m_id);
+    }
+
+  private:
+    TimerId m_id;
+  };
+
+  struct Stats
+  {
+    time::steady_clock::TimePoint since;
+    size_t nScheduled = 0;   ///< timers scheduled
+    size_t nFired = 0;       ///< timers fired
+    size_t nWakeups = 0;     ///< wakeups of the io_service by the wheel
+
+    /**
+     * @brief Wakeups per hour since the wheel was created
+     */
+    double
+    getWakeupsPerHour() const;
+  };
+
+  explicit
+  TimerWheel(boost::asio::io_service& ioService);
+
+  ~TimerWheel();
+
+  /**
+   * @brief Schedule @p callback to run after @p after, but no later than @p after + @p slack
+   */
+  TimerId
+  schedule(time::nanoseconds after, time::nanoseconds slack, const Callback& callback);
+
+  void
+  cancelAll();
+
+  size_t
+  size() const
+  {
+    return m_size;
+  }
+
+  const Stats&
+  getStats() const
+  {
+    return m_stats;
+  }
+
+private:
+  static constexpr size_t N_LEVELS = 8;
+  static constexpr size_t LEVEL_SHIFT = 3; // each level is 8 times coarser
+  static constexpr size_t N_SLOTS = 64;
+
+  using Slot = std::list<std::shared_ptr<Timer>>;
+
+  struct Timer
+  {
+    TimerWheel* wheel;
+    Callback callback;
+    time::steady_clock::TimePoint deadline;
+    uint64_t wakeupTick;
+
+    enum State {
+      SCHEDULED,
+      EXPIRED, // taken out of the wheel, waiting for its callback to be called
+      DONE
+    } state = SCHEDULED;
+
+    size_t level;
+    Slot::iterator position;
+  };
+
+  static uint64_t
+  getGranularity(size_t level)
+  {
+    return uint64_t(1) << (LEVEL_SHIFT * level);
+  }
+
+  uint64_t
+  toTick(time::steady_clock::TimePoint tp) const;
+
+  time::steady_clock::TimePoint
+  fromTick(uint64_t tick) const;
+
+  Slot&
+  getSlot(size_t level, uint64_t tick)
+  {
+    return m_levels[level][(tick >> (LEVEL_SHIFT * level)) % N_SLOTS];
+  }
+
+  void
+  cancel(Timer& timer);
+
+  void
+  arm();
+
+  void
+  expire();
+
+private:
+  util::detail::SteadyTimer m_timer;
+  time::steady_clock::TimePoint m_epoch; // tick 0, in ms
+  time::steady_clock::TimePoint m_armedFor;
+
+  std::array<std::array<Slot, N_SLOTS>, N_LEVELS> m_levels;
+  std::array<size_t, N_LEVELS> m_levelSizes{};
+  std::array<uint64_t, N_LEVELS> m_nextSlot{}; // first slot number not yet fully expired
+  size_t m_size = 0;
+  std::vector<std::shared_ptr<Timer>> m_expired; // timers of the wakeup in progress
+
+  bool m_isExpiring = false;
+  Stats m_stats;
+};
+
+} // namespace ndncert
+} // namespace ndn
+
+#endif // ICEAR_TIMER_WHEEL_HPP
@@ -0,0 +1,59 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+/**
+ * Replays a forwarder traffic capture (faceCapture start parameter) through MobileTerminal on a
+ * host machine and reports the CPU time the client spent on it.  Replay covers forwarder
+ * management and CA discovery, and stops at the first NDNCERT request (see ReplayTransport).
+ *
+ * Usage: face-replay <capture> [original|full]
+ */
+
+#include "../face-capture.hpp"
+#include "../mobile-terminal.hpp"
+
+#include <ndn-cxx/security/key-chain.hpp>
+
+#include <cstdlib>
+#include <ctime>
+#include <iostream>
+
+int
+main(int argc, char** argv)
+{
+  if (argc != 2 && argc != 3) {
+    std::cerr << "Usage: " << argv[0] << " <capture> [original|full]" << std::endl;
+    return 2;
+  }
+
+  auto timing = argc == 3 && std::string(argv[2]) == "full" ?
+                ndn::ndncert::ReplayTransport::Timing::FULL_SPEED :
+                ndn::ndncert::ReplayTransport::Timing::ORIGINAL;
+
+  // same as on the device: identities exist only for the lifetime of the process
+  ::setenv("NDN_CLIENT_PIB", "pib-memory", true);
+  ::setenv("NDN_CLIENT_TPM", "tpm-memory", true);
+
+  try {
+    auto transport = std::make_shared<ndn::ndncert::ReplayTransport>(argv[1], timing);
+    ndn::KeyChain keyChain;
+    ndn::ndncert::MobileTerminal terminal(keyChain, [] { return true; }, transport);
+
+    transport->onFinished.connect([&terminal] {
+        terminal.doStop();
+      });
+
+    auto wallStart = ndn::time::steady_clock::now();
+    std::clock_t cpuStart = std::clock();
+    terminal.doStart();
+    std::clock_t cpuEnd = std::clock();
+
+    std::cout << "wall: "
+              << ndn::time::duration_cast<ndn::time::milliseconds>(ndn::time::steady_clock::now() - wallStart)
+              << ", cpu: " << (cpuEnd - cpuStart) * 1000 / CLOCKS_PER_SEC << " ms" << std::endl;
+    return terminal.retval == 0 ? 0 : 1;
+  }
+  catch (const std::exception& e) {
+    std::cerr << "ERROR: " << e.what() << std::endl;
+    return 1;
+  }
+}
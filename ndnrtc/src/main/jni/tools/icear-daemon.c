@@ -0,0 +1,96 @@
+/* -*- Mode:C; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+/**
+ * Runs the bootstrap client on a Linux host through the C API of icear-core, printing its log to
+ * stderr, until interrupted.
+ *
+ * Usage: icear-daemon <home-directory> [<name>=<value> start parameter]...
+ */
+
+#include "../icear-core.h"
+
+#include <signal.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+static volatile sig_atomic_t g_isInterrupted = 0;
+
+static void
+onSignal(int signal)
+{
+  (void)signal;
+  g_isInterrupted = 1;
+}
+
+static void
+onLog(void* context, const char* module, const char* severity, const char* message)
+{
+  (void)context;
+  fprintf(stderr, "%s %s: %s\n", severity, module, message);
+}
+
+static void
+onStopped(void* context)
+{
+  *(volatile sig_atomic_t*)context = 1;
+}
+
+int
+main(int argc, char** argv)
+{
+  enum { MAX_PARAMS = 32 };
+  icear_param params[MAX_PARAMS];
+  size_t nParams = 0;
+  static char buffer[MAX_PARAMS][256];
+  volatile sig_atomic_t isStopped = 0;
+  icear_callbacks callbacks = {0};
+  icear_terminal* terminal;
+  int i;
+
+  if (argc < 2 || argc > MAX_PARAMS) {
+    fprintf(stderr, "Usage: %s <home-directory> [<name>=<value>]...\n", argv[0]);
+    return 2;
+  }
+
+  params[nParams].key = "homePath";
+  params[nParams].value = argv[1];
+  ++nParams;
+  for (i = 2; i < argc; ++i) {
+    char* value;
+    strncpy(buffer[nParams], argv[i], sizeof(buffer[nParams]) - 1);
+    value = strchr(buffer[nParams], '=');
+    if (value == NULL) {
+      fprintf(stderr, "Start parameter must be <name>=<value>: %s\n", argv[i]);
+      return 2;
+    }
+    *value = '\0';
+    params[nParams].key = buffer[nParams];
+    params[nParams].value = value + 1;
+    ++nParams;
+  }
+
+  icear_log_subscribe(&onLog, NULL);
+  signal(SIGINT, &onSignal);
+  signal(SIGTERM, &onSignal);
+
+  terminal = icear_terminal_create();
+  if (terminal == NULL) {
+    return 1;
+  }
+
+  /* no get_network: every network change reported by the forwarder triggers a new bootstrap */
+  callbacks.context = (void*)&isStopped;
+  callbacks.on_stopped = &onStopped;
+  if (icear_terminal_start(terminal, params, nParams, &callbacks) == ICEAR_ERROR) {
+    icear_terminal_destroy(terminal);
+    return 1;
+  }
+
+  while (!g_isInterrupted && !isStopped) {
+    sleep(1);
+  }
+
+  icear_terminal_destroy(terminal);
+  return 0;
+}
@@ -0,0 +1,101 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+/**
+ * Offline decoder of the native log ring (ice-ar-log.ring), including binary records.
+ *
+ * Usage: log-ring-decode <ice-ar-log.ring>
+ *
+ * The file can be pulled from a device with
+ *
+ *     adb exec-out run-as net.named_data.ice_ar.sec_demo1 cat files/ice-ar-log.ring > ice-ar-log.ring
+ */
+
+#include "../binary-log.hpp"
+
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <vector>
+
+static const uint32_t MAGIC = 0x524c4349; // 'ICLR'
+static const uint32_t VERSION = 1;
+static const size_t HEADER_SIZE = 64;
+static const size_t RECORD_HEADER_SIZE = 24;
+
+static const char* const SEVERITIES[] = {"FATAL", "NONE", "ERROR", "WARN", "INFO", "DEBUG", "TRACE"};
+
+template<typename T>
+static T
+read(const std::vector<uint8_t>& buffer, size_t pos)
+{
+  T value;
+  std::memcpy(&value, buffer.data() + pos, sizeof(value));
+  return value;
+}
+
+int
+main(int argc, char** argv)
+{
+  if (argc != 2) {
+    std::cerr << "Usage: " << argv[0] << " <ice-ar-log.ring>" << std::endl;
+    return 2;
+  }
+
+  std::ifstream is(argv[1], std::ios::binary);
+  std::vector<uint8_t> file((std::istreambuf_iterator<char>(is)), std::istreambuf_iterator<char>());
+  if (file.size() < HEADER_SIZE ||
+      read<uint32_t>(file, 0) != MAGIC || read<uint32_t>(file, 4) != VERSION) {
+    std::cerr << "ERROR: " << argv[1] << " is not a log ring" << std::endl;
+    return 1;
+  }
+
+  uint64_t dataSize = read<uint32_t>(file, 8);
+  uint64_t head = read<uint64_t>(file, 16);
+  uint64_t tail = read<uint64_t>(file, 24);
+  if (HEADER_SIZE + dataSize > file.size() || tail > head || head - tail > dataSize) {
+    std::cerr << "ERROR: corrupted log ring header" << std::endl;
+    return 1;
+  }
+
+  for (uint64_t offset = tail; offset < head;) {
+    size_t pos = HEADER_SIZE + offset % dataSize;
+    uint32_t size = read<uint32_t>(file, pos);
+    if (size == 0 || size > dataSize) {
+      std::cerr << "ERROR: corrupted record at offset " << offset << std::endl;
+      return 1;
+    }
+    offset += size;
+
+    uint8_t type = file[pos + 4];
+    if (type != icear::LogRing::TEXT && type != icear::LogRing::BINARY) {
+      continue;
+    }
+
+    uint8_t severity = file[pos + 5];
+    uint16_t moduleSize = read<uint16_t>(file, pos + 6);
+    uint32_t payloadSize = read<uint32_t>(file, pos + 8);
+    uint64_t timestamp = read<uint64_t>(file, pos + 16);
+    const uint8_t* module = file.data() + pos + RECORD_HEADER_SIZE;
+    const uint8_t* payload = module + moduleSize;
+
+    std::time_t seconds = static_cast<std::time_t>(timestamp / 1000);
+    char time[32];
+    std::strftime(time, sizeof(time), "%Y-%m-%d %H:%M:%S", std::gmtime(&seconds));
+
+    std::cout << time << "." << std::setfill('0') << std::setw(3) << timestamp % 1000 << " "
+              << (severity < 7 ? SEVERITIES[severity] : "ALL") << ": ["
+              << std::string(reinterpret_cast<const char*>(module), moduleSize) << "] ";
+    if (type == icear::LogRing::BINARY) {
+      std::cout << icear::blog::format(payload, payloadSize);
+    }
+    else {
+      std::cout.write(reinterpret_cast<const char*>(payload), payloadSize);
+    }
+    std::cout << "\n";
+  }
+
+  return 0;
+}